@@ -1,5 +1,8 @@
 #include "src/nes.h"
+#include "src/cpu/code_tracer.h"
 
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
@@ -7,13 +10,160 @@ int main(int argc, char **argv)
 {
     std::unique_ptr<NES> nes;
 
-    if (argc != 2)
+    const char *cartridge_path = nullptr;
+    const char *trace_path = nullptr;
+    const char *listing_path = nullptr;
+    const char *module_source_path = nullptr;
+    const char *module_path = nullptr;
+    const char *palette_path = nullptr;
+    Stepping_Mode stepping_mode = CycleStepped;
+    bool block_translation = false;
+    bool idle_skipping = false;
+    bool idiom_fusing = false;
+    unsigned int skipped_frames = 0;
+    unsigned int frame_period = 0;
+    Pixel_Format pixel_format = XRGB8888;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (std::strcmp(argv[arg], "--instruction-stepped") == 0)
+        {
+            stepping_mode = InstructionStepped;
+        }
+        else if (std::strcmp(argv[arg], "--translate-blocks") == 0)
+        {
+            stepping_mode = InstructionStepped;
+            block_translation = true;
+        }
+        else if (std::strcmp(argv[arg], "--skip-idle-loops") == 0)
+        {
+            idle_skipping = true;
+        }
+        else if (std::strcmp(argv[arg], "--fuse-idioms") == 0)
+        {
+            idiom_fusing = true;
+        }
+        else if (std::strcmp(argv[arg], "--frame-skip") == 0)
+        {
+            // a bad ratio would otherwise be taken for the cartridge path
+            if (arg + 1 == argc || std::sscanf(argv[arg + 1], "%u/%u", &skipped_frames, &frame_period) != 2 ||
+                skipped_frames >= frame_period || frame_period > 0xff)
+            {
+                printf("[Ciel] --frame-skip needs n/m with n < m <= 255!\n");
+                return 1;
+            }
+
+            ++arg;
+        }
+        else if (std::strcmp(argv[arg], "--pixel-format") == 0)
+        {
+            const char *format_name = (arg + 1 < argc) ? argv[++arg] : "";
+
+            if (std::strcmp(format_name, "rgb24") == 0)
+            {
+                pixel_format = RGB24;
+            }
+            else if (std::strcmp(format_name, "xrgb8888") == 0)
+            {
+                pixel_format = XRGB8888;
+            }
+            else if (std::strcmp(format_name, "rgb565") == 0)
+            {
+                pixel_format = RGB565;
+            }
+            else
+            {
+                printf("[Ciel] --pixel-format needs rgb24, xrgb8888 or rgb565!\n");
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc)
+        {
+            trace_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--palette") == 0 && arg + 1 < argc)
+        {
+            palette_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--disassemble") == 0 && arg + 1 < argc)
+        {
+            listing_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--recompile") == 0 && arg + 1 < argc)
+        {
+            module_source_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--recompiled") == 0 && arg + 1 < argc)
+        {
+            stepping_mode = InstructionStepped;
+            module_path = argv[++arg];
+        }
+        else if (cartridge_path == nullptr)
+        {
+            cartridge_path = argv[arg];
+        }
+        else
+        {
+            cartridge_path = nullptr;
+            break;
+        }
+    }
+
+    if (cartridge_path == nullptr)
     {
         printf("[Ciel] Please provide one program argument!\n");
     }
+    else if (listing_path != nullptr)
+    {
+        Code_Tracer(cartridge_path).write_listing(listing_path);
+    }
+    else if (module_source_path != nullptr)
+    {
+        Code_Tracer(cartridge_path).write_module(module_source_path);
+    }
     else
     {
-        nes = std::make_unique<NES>(argv[1]);
+        nes = std::make_unique<NES>(cartridge_path, stepping_mode);
+
+        if (palette_path != nullptr)
+        {
+            nes->load_palette(palette_path);
+        }
+
+        if (pixel_format != XRGB8888)
+        {
+            nes->set_pixel_format(pixel_format);
+        }
+
+        if (trace_path != nullptr)
+        {
+            nes->enable_trace(trace_path);
+        }
+
+        if (block_translation)
+        {
+            nes->enable_block_translation(true);
+        }
+
+        if (module_path != nullptr)
+        {
+            nes->load_recompiled(module_path);
+        }
+
+        if (idle_skipping)
+        {
+            nes->enable_idle_skipping();
+        }
+
+        if (idiom_fusing)
+        {
+            nes->enable_idiom_fusing();
+        }
+
+        if (frame_period != 0)
+        {
+            nes->enable_frame_skip(skipped_frames, frame_period);
+        }
 
         nes->run();
     }
@@ -0,0 +1,780 @@
+#include "code_tracer.h"
+
+#include "disassembler.h"
+#include "opcodes.h"
+#include "recompiled.h"
+#include "..//mmu/cartridge.h"
+#include "..//mmu/mappers/mapper_interface/mapper.h"
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstring>
+#include <stdexcept>
+
+enum Vector_Address
+{
+    NMIVector = 0xfffa,
+    ResetVector = 0xfffc,
+    IRQVector = 0xfffe
+};
+
+Code_Tracer::Code_Tracer(const char *cartridge_path) :
+cart(std::make_unique<Cartridge>(cartridge_path)), kinds(0x8000, DataByte), labels(0x8000, NoLabel), unresolved_jumps(),
+prg_base(cart->get_info().prg_banks == 1 ? 0xc000 : 0x8000), code_bytes(0), subroutines(0)
+{
+}
+
+Code_Tracer::~Code_Tracer()
+= default;
+
+uint16_t Code_Tracer::fold(const uint16_t address) const
+{
+    if (prg_base == 0xc000)
+    {
+        return address | 0x4000u;
+    }
+
+    return address;
+}
+
+uint8_t Code_Tracer::read_prg(const uint16_t address) const
+{
+    return cart->mapper->read_byte(address);
+}
+
+uint16_t Code_Tracer::read_vector(const uint16_t address) const
+{
+    return (uint16_t)(read_prg(address + 1) << 8u) | read_prg(address);
+}
+
+void Code_Tracer::add_label(const uint16_t address, const Label_Kind kind)
+{
+    // code copied to RAM can't be followed
+    if (address < 0x8000)
+    {
+        return;
+    }
+
+    uint8_t &label = labels[fold(address) - 0x8000];
+
+    if (kind == SubroutineLabel && label < SubroutineLabel)
+    {
+        ++subroutines;
+    }
+
+    if (kind > label)
+    {
+        label = kind;
+    }
+}
+
+void Code_Tracer::trace(const uint16_t entry)
+{
+    std::vector<uint16_t> pending { entry };
+
+    while (!pending.empty())
+    {
+        uint32_t pc = pending.back();
+
+        pending.pop_back();
+
+        while (pc >= 0x8000 && pc <= 0xffff)
+        {
+            pc = fold(pc);
+
+            const uint8_t opcode = read_prg(pc);
+            const Opcode_Info &info = opcode_table[opcode];
+            const uint8_t length = instruction_length(info.mode);
+
+            // unknown opcodes end the path, whatever follows could as well be data
+            if (info.cycles == 0 || pc + length > 0x10000)
+            {
+                break;
+            }
+
+            bool traced = false;
+
+            for (uint8_t i = 0; i < length; i++)
+            {
+                traced |= kinds[pc - 0x8000 + i] != DataByte;
+            }
+
+            // either known already or overlapping another instruction
+            if (traced)
+            {
+                break;
+            }
+
+            kinds[pc - 0x8000] = OpcodeByte;
+
+            for (uint8_t i = 1; i < length; i++)
+            {
+                kinds[pc - 0x8000 + i] = OperandByte;
+            }
+
+            code_bytes += length;
+
+            const uint32_t next = pc + length;
+            uint16_t target = 0;
+
+            if (length == 3)
+            {
+                target = read_vector(pc + 1);
+            }
+            else if (info.mode == Relative)
+            {
+                target = next + (int8_t)read_prg(pc + 1);
+
+                add_label(target, LocalLabel);
+                pending.push_back(target);
+            }
+
+            if (opcode == 0x20)
+            {
+                add_label(target, SubroutineLabel);
+                pending.push_back(target);
+            }
+            else if (opcode == 0x4c)
+            {
+                add_label(target, LocalLabel);
+                pending.push_back(target);
+                break;
+            }
+            else if (opcode == 0x6c && target >= 0x8000)
+            {
+                // pointers in PRG-ROM can't change, the high byte wraps within the page like on the 2A03
+                const uint16_t pointer_hi = (target & 0xff00u) | (uint8_t)(target + 1);
+
+                target = (uint16_t)(read_prg(pointer_hi) << 8u) | read_prg(target);
+
+                add_label(target, LocalLabel);
+                pending.push_back(target);
+                break;
+            }
+            else if (opcode == 0x6c)
+            {
+                unresolved_jumps.push_back(pc);
+                break;
+            }
+            else if (opcode == 0x00)
+            {
+                // the IRQ handler returns past the byte after BRK
+                add_label(next + 1, LocalLabel);
+                pending.push_back(next + 1);
+                break;
+            }
+            else if (opcode == 0x40 || opcode == 0x60)
+            {
+                break;
+            }
+
+            pc = next;
+        }
+    }
+}
+
+void Code_Tracer::write_label(std::FILE *file, const uint16_t address) const
+{
+    switch (labels[address - 0x8000])
+    {
+        case LocalLabel:
+            std::fprintf(file, "loc_%04X:\n", address);
+            break;
+        case SubroutineLabel:
+            std::fprintf(file, "\nsub_%04X:\n", address);
+            break;
+        case VectorLabel:
+            std::fprintf(file, "\n");
+
+            if (fold(read_vector(ResetVector)) == address)
+            {
+                std::fprintf(file, "reset:\n");
+            }
+
+            if (fold(read_vector(NMIVector)) == address)
+            {
+                std::fprintf(file, "nmi:\n");
+            }
+
+            if (fold(read_vector(IRQVector)) == address)
+            {
+                std::fprintf(file, "irq:\n");
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Code_Tracer::write_instruction(std::FILE *file, const uint16_t address) const
+{
+    const Opcode_Info &info = opcode_table[read_prg(address)];
+    const uint8_t length = instruction_length(info.mode);
+    uint8_t bytes[3] {};
+
+    char machine_code[10];
+    char assembly[16];
+    char cycles[32];
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        bytes[i] = read_prg(address + i);
+
+        std::snprintf(&machine_code[3 * i], 4, "%02X ", bytes[i]);
+    }
+
+    machine_code[3 * length - 1] = 0;
+
+    disassemble(address, bytes, assembly, sizeof(assembly));
+
+    if (info.mode == Relative)
+    {
+        std::snprintf(cycles, sizeof(cycles), "%u (+1 taken, +1 page)", info.cycles);
+    }
+    else if (bytes[0] == 0x6c && bytes[2] < 0x80)
+    {
+        std::snprintf(cycles, sizeof(cycles), "%u, target unresolved", info.cycles);
+    }
+    else if (info.page_cross_penalty)
+    {
+        std::snprintf(cycles, sizeof(cycles), "%u (+1 page)", info.cycles);
+    }
+    else
+    {
+        std::snprintf(cycles, sizeof(cycles), "%u", info.cycles);
+    }
+
+    std::fprintf(file, "    %04X  %-8s  %-13s ; %s\n", address, machine_code, assembly, cycles);
+}
+
+void Code_Tracer::write_data(std::FILE *file, const uint16_t address, const uint32_t end) const
+{
+    std::fprintf(file, "    %04X  .byte ", address);
+
+    for (uint32_t i = address; i < end; i++)
+    {
+        std::fprintf(file, i + 1 < end ? "$%02X, " : "$%02X\n", read_prg(i));
+    }
+}
+
+bool Code_Tracer::trace_program()
+{
+    if (cart->get_info().mapper_number != 0)
+    {
+        printf("[Tracer] Only NROM games can be traced statically, PRG-ROM banks of other mappers move at runtime\n");
+        return false;
+    }
+
+    for (const uint16_t vector : { ResetVector, NMIVector, IRQVector })
+    {
+        add_label(read_vector(vector), VectorLabel);
+        trace(read_vector(vector));
+    }
+
+    return true;
+}
+
+void Code_Tracer::write_listing(const char *path)
+{
+    if (!trace_program())
+    {
+        return;
+    }
+
+    std::FILE *file = std::fopen(path, "w");
+
+    if (file == nullptr)
+    {
+        throw std::runtime_error("[Tracer] Couldn't open listing file!");
+    }
+
+    std::fprintf(file, "; PRG-ROM listed from %04Xh, mirrored addresses are folded into it\n", prg_base);
+    std::fprintf(file, "; %u bytes of code in %u subroutines, %u bytes of data\n",
+            code_bytes, subroutines, 0x10000 - prg_base - code_bytes);
+
+    for (const uint16_t jump : unresolved_jumps)
+    {
+        std::fprintf(file, "; indirect jump at %04Xh left unresolved, its pointer is in RAM\n", jump);
+    }
+
+    std::fprintf(file, "; cycles are base counts, page crossings and taken branches add the noted extras\n");
+
+    uint32_t address = prg_base;
+
+    while (address <= 0xffff)
+    {
+        write_label(file, address);
+
+        if (kinds[address - 0x8000] == OpcodeByte)
+        {
+            write_instruction(file, address);
+
+            address += instruction_length(opcode_table[read_prg(address)].mode);
+        }
+        else
+        {
+            uint32_t end = address + 1;
+
+            while (end <= 0xffff && end - address < 8 && kinds[end - 0x8000] != OpcodeByte &&
+                    labels[end - 0x8000] == NoLabel)
+            {
+                ++end;
+            }
+
+            write_data(file, address, end);
+
+            address = end;
+        }
+    }
+
+    std::fclose(file);
+
+    printf("[Tracer] Wrote listing of %u code bytes to \"%s\"\n", code_bytes, path);
+}
+
+// what the whole-instruction handlers do with their operand, %s is the byte read or the one modified in place
+struct Recompiled_Operation
+{
+    const char *mnemonic;
+    const char *statement;
+};
+
+static const Recompiled_Operation recompiled_operations[] = {
+        { "ADC", "recompiled_adc(context, %s);" },
+        { "AND", "recompiled_load(context, context->a, context->a & %s);" },
+        { "ASL", "recompiled_asl(context, %s);" },
+        { "BIT", "recompiled_bit(context, %s);" },
+        { "CLC", "context->p &= 0xfeu;" },
+        { "CLD", "context->p &= 0xf7u;" },
+        { "CLV", "context->p &= 0xbfu;" },
+        { "CMP", "recompiled_compare(context, context->a, %s);" },
+        { "CPX", "recompiled_compare(context, context->x, %s);" },
+        { "CPY", "recompiled_compare(context, context->y, %s);" },
+        { "DEC", "recompiled_load(context, %s, %s - 1);" },
+        { "DEX", "recompiled_load(context, context->x, context->x - 1);" },
+        { "DEY", "recompiled_load(context, context->y, context->y - 1);" },
+        { "EOR", "recompiled_load(context, context->a, context->a ^ %s);" },
+        { "INC", "recompiled_load(context, %s, %s + 1);" },
+        { "INX", "recompiled_load(context, context->x, context->x + 1);" },
+        { "INY", "recompiled_load(context, context->y, context->y + 1);" },
+        { "LDA", "recompiled_load(context, context->a, %s);" },
+        { "LDX", "recompiled_load(context, context->x, %s);" },
+        { "LDY", "recompiled_load(context, context->y, %s);" },
+        { "LSR", "recompiled_lsr(context, %s);" },
+        { "NOP", "" },
+        { "ORA", "recompiled_load(context, context->a, context->a | %s);" },
+        { "ROL", "recompiled_rol(context, %s);" },
+        { "ROR", "recompiled_ror(context, %s);" },
+        { "SBC", "recompiled_adc(context, ~%s);" },
+        { "SEC", "context->p |= 0x1u;" },
+        { "SED", "context->p |= 0x8u;" },
+        { "SEI", "context->p |= 0x4u;" },
+        { "TAX", "recompiled_load(context, context->x, context->a);" },
+        { "TAY", "recompiled_load(context, context->y, context->a);" },
+        { "TSX", "recompiled_load(context, context->x, context->sp);" },
+        { "TXA", "recompiled_load(context, context->a, context->x);" },
+        { "TXS", "context->sp = context->x;" },
+        { "TYA", "recompiled_load(context, context->a, context->y);" }
+};
+
+// one line of a case in a routine
+static void write_code(std::FILE *file, const char *format, ...)
+{
+    std::va_list arguments;
+
+    va_start(arguments, format);
+
+    std::fprintf(file, "            ");
+    std::vfprintf(file, format, arguments);
+    std::fprintf(file, "\n");
+
+    va_end(arguments);
+}
+
+static void write_operand_statement(std::FILE *file, const char *mnemonic, const char *operand)
+{
+    for (const Recompiled_Operation &operation : recompiled_operations)
+    {
+        if (std::strcmp(operation.mnemonic, mnemonic) == 0 && operation.statement[0] != 0)
+        {
+            std::fprintf(file, "            ");
+            std::fprintf(file, operation.statement, operand, operand);
+            std::fprintf(file, "\n");
+        }
+    }
+}
+
+static const char *branch_condition(const uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case 0x10:
+            return "(context->n_result & 0x80u) == 0";
+        case 0x30:
+            return "(context->n_result & 0x80u) != 0";
+        case 0x50:
+            return "(context->p & 0x40u) == 0";
+        case 0x70:
+            return "(context->p & 0x40u) != 0";
+        case 0x90:
+            return "(context->p & 0x1u) == 0";
+        case 0xb0:
+            return "(context->p & 0x1u) != 0";
+        case 0xd0:
+            return "context->z_result != 0";
+        default:
+            return "context->z_result == 0";
+    }
+}
+
+bool Code_Tracer::is_recompiled(const uint32_t address) const
+{
+    // the 2A03 core has no CLI and faults on it like on an unknown opcode, so that is left to it
+    return address >= 0x8000 && address <= 0xffff && kinds[address - 0x8000] == OpcodeByte && read_prg(address) != 0x58;
+}
+
+uint32_t Code_Tracer::jump_target(const uint16_t address) const
+{
+    const uint8_t opcode = read_prg(address);
+
+    if (opcode_table[opcode].mode == Relative)
+    {
+        return (uint16_t)(address + 2 + (int8_t)read_prg(address + 1));
+    }
+
+    if (opcode == 0x20 || opcode == 0x4c)
+    {
+        return read_vector(address + 1);
+    }
+
+    return 0x10000;
+}
+
+void Code_Tracer::write_operation(std::FILE *file, const uint16_t address, const uint16_t start,
+                                  const uint32_t end) const
+{
+    const uint8_t opcode = read_prg(address);
+    const Opcode_Info &info = opcode_table[opcode];
+    const uint16_t next = address + instruction_length(info.mode);
+    const uint8_t operand = read_prg(address + 1);
+    const uint16_t absolute = read_vector(address + 1);
+    const uint32_t target = jump_target(address);
+    const char *store = (info.access == ReadAccess) ? "false" : "true";
+    const char *index = (info.mode == ZeroPageY || info.mode == AbsoluteY) ? "context->y" : "context->x";
+
+    // targets in the routine are jumped to, anything else goes back to the emulator to be looked up
+    const auto write_jump = [&](const char *indent)
+    {
+        if (target >= start && target < end && is_recompiled(target))
+        {
+            write_code(file, "%sif (recompiled_retire(context, start))", indent);
+            write_code(file, "%s{", indent);
+            write_code(file, "%s    return 0x%04Xu;", indent, target);
+            write_code(file, "%s}\n", indent);
+            write_code(file, "%sgoto loc_%04X;", indent, target);
+        }
+        else
+        {
+            write_code(file, "%s(void)recompiled_retire(context, start);", indent);
+            write_code(file, "%sreturn 0x%04Xu;", indent, target);
+        }
+    };
+
+    write_code(file, "start = context->cycles;");
+
+    // cycles are added up to each bus access, so handlers see the count they would have under run_instruction
+    switch (opcode)
+    {
+        case 0x00:
+            write_code(file, "context->cycles += 7;");
+            write_code(file, "recompiled_push(context, 0x%02Xu);", (uint16_t)(address + 2) >> 8u);
+            write_code(file, "recompiled_push(context, 0x%02Xu);", (uint8_t)(address + 2));
+            write_code(file, "recompiled_push(context, recompiled_status(context) | 0x10u);");
+            write_code(file, "address = (uint16_t)(recompiled_read(context, 0xffffu, 0x%04Xu) << 8u) |", address);
+            write_code(file, "        recompiled_read(context, 0xfffeu, 0x%04Xu);", address);
+            write_code(file, "(void)recompiled_retire(context, start);");
+            write_code(file, "return address;");
+            return;
+        case 0x20:
+            write_code(file, "context->cycles += 6;");
+            write_code(file, "recompiled_push(context, 0x%02Xu);", (uint16_t)(address + 2) >> 8u);
+            write_code(file, "recompiled_push(context, 0x%02Xu);", (uint8_t)(address + 2));
+            write_jump("");
+            return;
+        case 0x40:
+            write_code(file, "context->cycles += 6;");
+            write_code(file, "recompiled_pull_status(context);");
+            write_code(file, "++context->sp;");
+            write_code(file, "value = recompiled_pull(context);");
+            write_code(file, "++context->sp;");
+            write_code(file, "address = (uint16_t)(recompiled_pull(context) << 8u) | value;");
+            write_code(file, "(void)recompiled_retire(context, start);");
+            write_code(file, "return address;");
+            return;
+        case 0x4c:
+            write_code(file, "context->cycles += 3;");
+            write_jump("");
+            return;
+        case 0x60:
+            write_code(file, "context->cycles += 6;");
+            write_code(file, "++context->sp;");
+            write_code(file, "value = recompiled_pull(context);");
+            write_code(file, "++context->sp;");
+            write_code(file, "address = (uint16_t)(recompiled_pull(context) << 8u) | value;");
+            write_code(file, "(void)recompiled_retire(context, start);");
+            write_code(file, "return address + 1;");
+            return;
+        case 0x6c:
+            // the high byte of the pointer wraps within its page
+            write_code(file, "context->cycles += 3;");
+            write_code(file, "value = recompiled_read(context, 0x%04Xu, 0x%04Xu);", absolute, address);
+            write_code(file, "++context->cycles;");
+            write_code(file, "address = (uint16_t)(recompiled_read(context, 0x%04Xu, 0x%04Xu) << 8u) | value;",
+                    (absolute & 0xff00u) | (uint8_t)(absolute + 1), address);
+            write_code(file, "++context->cycles;");
+            write_code(file, "(void)recompiled_retire(context, start);");
+            write_code(file, "return address;");
+            return;
+        case 0x08:
+            write_code(file, "context->cycles += 3;");
+            write_code(file, "recompiled_push(context, recompiled_status(context) | 0x30u);");
+            break;
+        case 0x28:
+            write_code(file, "context->cycles += 4;");
+            write_code(file, "recompiled_pull_status(context);");
+            break;
+        case 0x48:
+            write_code(file, "context->cycles += 3;");
+            write_code(file, "recompiled_push(context, context->a);");
+            break;
+        case 0x68:
+            write_code(file, "context->cycles += 4;");
+            write_code(file, "++context->sp;");
+            write_code(file, "recompiled_load(context, context->a, recompiled_pull(context));");
+            break;
+        default:
+            if (info.mode == Relative)
+            {
+                write_code(file, "context->cycles += 2;\n");
+                write_code(file, "if (%s)", branch_condition(opcode));
+                write_code(file, "{");
+                write_code(file, "    context->cycles += %u;\n", ((next ^ target) & 0xff00u) ? 2 : 1);
+                write_jump("    ");
+                write_code(file, "}");
+                break;
+            }
+
+            switch (info.mode)
+            {
+                case ZeroPage:
+                    write_code(file, "context->cycles += 2;");
+                    write_code(file, "address = 0x%02Xu;", operand);
+                    break;
+                case ZeroPageX:
+                case ZeroPageY:
+                    write_code(file, "context->cycles += 3;");
+                    write_code(file, "address = (uint8_t)(0x%02Xu + %s);", operand, index);
+                    break;
+                case Absolute:
+                    write_code(file, "context->cycles += 3;");
+                    write_code(file, "address = 0x%04Xu;", absolute);
+                    break;
+                case AbsoluteX:
+                case AbsoluteY:
+                    write_code(file, "context->cycles += 3;");
+                    write_code(file, "address = recompiled_index(context, 0x%04Xu, %s, %s, 0x%04Xu);", absolute, index,
+                            store, address);
+                    break;
+                case IndexedIndirect:
+                    write_code(file, "context->cycles += 5;");
+                    write_code(file, "address = recompiled_pointer(context, (uint8_t)(0x%02Xu + context->x));",
+                            operand);
+                    break;
+                case IndirectIndexed:
+                    write_code(file, "context->cycles += 4;");
+                    write_code(file, "address = recompiled_index(context, recompiled_pointer(context, 0x%02Xu), "
+                                     "context->y, %s, 0x%04Xu);", operand, store, address);
+                    break;
+                default:
+                    write_code(file, "context->cycles += 2;");
+                    break;
+            }
+
+            if (info.mode == Immediate)
+            {
+                write_code(file, "value = 0x%02Xu;", operand);
+                write_operand_statement(file, info.mnemonic, "value");
+            }
+            else if (info.mode == Accumulator)
+            {
+                write_operand_statement(file, info.mnemonic, "context->a");
+            }
+            else if (info.access == ReadAccess)
+            {
+                write_code(file, "value = recompiled_read(context, address, 0x%04Xu);", address);
+                write_code(file, "++context->cycles;");
+                write_operand_statement(file, info.mnemonic, "value");
+            }
+            else if (info.access == WriteAccess)
+            {
+                write_code(file, "recompiled_write(context, context->%c, address, 0x%04Xu);",
+                        info.mnemonic[2] - 'A' + 'a', address);
+                write_code(file, "++context->cycles;");
+            }
+            else if (info.access == ReadModifyWriteAccess)
+            {
+                // the unmodified value is written back first, and writing it to OAMDMA starts the DMA in between
+                write_code(file, "value = recompiled_read(context, address, 0x%04Xu);", address);
+                write_code(file, "++context->cycles;");
+                write_code(file, "recompiled_write(context, value, address, 0x%04Xu);", address);
+                write_operand_statement(file, info.mnemonic, "value");
+                write_code(file, "++context->cycles;\n");
+                write_code(file, "if (*context->oam_dma)");
+                write_code(file, "{");
+                write_code(file, "    context->run_oam_dma(context);");
+                write_code(file, "}\n");
+                write_code(file, "recompiled_write(context, value, address, 0x%04Xu);", address);
+                write_code(file, "++context->cycles;");
+            }
+            else
+            {
+                write_operand_statement(file, info.mnemonic, "");
+            }
+            break;
+    }
+
+    std::fprintf(file, "\n");
+    write_code(file, "if (recompiled_retire(context, start))");
+    write_code(file, "{");
+    write_code(file, "    return 0x%04Xu;", next);
+    write_code(file, "}");
+}
+
+void Code_Tracer::write_routine(std::FILE *file, const uint16_t start, const uint32_t end) const
+{
+    std::vector<bool> jump_targets(end - start, false);
+
+    for (uint32_t address = start; address < end; address += instruction_length(opcode_table[read_prg(address)].mode))
+    {
+        const uint32_t target = jump_target(address);
+
+        if (target >= start && target < end && is_recompiled(target))
+        {
+            jump_targets[target - start] = true;
+        }
+    }
+
+    std::fprintf(file, "\nstatic uint16_t routine_%04X(Recompiled_Context *context, const uint16_t pc)\n{\n", start);
+    std::fprintf(file, "    uint64_t start;\n");
+    std::fprintf(file, "    [[maybe_unused]] uint16_t address;\n    [[maybe_unused]] uint8_t value;\n\n");
+    std::fprintf(file, "    switch (pc)\n    {\n");
+
+    for (uint32_t address = start; address < end;)
+    {
+        const uint8_t length = instruction_length(opcode_table[read_prg(address)].mode);
+        uint8_t bytes[3] {};
+        char assembly[16];
+
+        for (uint8_t i = 0; i < length; i++)
+        {
+            bytes[i] = read_prg(address + i);
+        }
+
+        disassemble(address, bytes, assembly, sizeof(assembly));
+
+        std::fprintf(file, "        // %s\n        case 0x%04Xu:\n", assembly, address);
+
+        if (jump_targets[address - start])
+        {
+            std::fprintf(file, "        loc_%04X:\n", address);
+        }
+
+        write_operation(file, address, start, end);
+        std::fprintf(file, "\n");
+
+        address += length;
+    }
+
+    std::fprintf(file, "        default:\n            return pc;\n    }\n\n    return 0x%04Xu;\n}\n", end & 0xffffu);
+}
+
+void Code_Tracer::write_module(const char *path)
+{
+    if (!trace_program())
+    {
+        return;
+    }
+
+    std::vector<uint16_t> entries;
+    std::vector<uint16_t> entry_routines;
+    uint32_t routines = 0;
+
+    std::FILE *file = std::fopen(path, "w");
+
+    if (file == nullptr)
+    {
+        throw std::runtime_error("[Tracer] Couldn't open module source file!");
+    }
+
+    std::fprintf(file, "// NROM code from %04Xh on, recompiled for Ciel's instruction-stepped core\n", prg_base);
+    std::fprintf(file, "// build it as a shared library with src/cpu on the include path, and load it with\n");
+    std::fprintf(file, "// --recompiled\n\n");
+    std::fprintf(file, "#include \"recompiled.h\"\n");
+
+    uint32_t address = prg_base;
+
+    // every run of instructions that follow each other becomes a routine that can be entered at any of them
+    while (address <= 0xffff)
+    {
+        if (!is_recompiled(address))
+        {
+            ++address;
+            continue;
+        }
+
+        uint32_t end = address;
+
+        while (is_recompiled(end))
+        {
+            entries.push_back(end);
+            entry_routines.push_back(address);
+
+            end += instruction_length(opcode_table[read_prg(end)].mode);
+        }
+
+        write_routine(file, address, end);
+
+        ++routines;
+        address = end;
+    }
+
+    if (entries.empty())
+    {
+        std::fclose(file);
+        throw std::runtime_error("[Tracer] No code to recompile!");
+    }
+
+    uint64_t checksum = recompiled_hash_seed;
+
+    for (uint32_t prg_address = 0x8000; prg_address <= 0xffff; prg_address++)
+    {
+        checksum = recompiled_hash(checksum, read_prg(prg_address));
+    }
+
+    std::fprintf(file, "\nstatic const Recompiled_Entry entries[] = {\n");
+
+    for (size_t entry = 0; entry < entries.size(); entry++)
+    {
+        std::fprintf(file, "        { 0x%04Xu, routine_%04X }%s\n", entries[entry], entry_routines[entry],
+                entry + 1 < entries.size() ? "," : "");
+    }
+
+    std::fprintf(file, "};\n\nstatic const Recompiled_Module module = {\n");
+    std::fprintf(file, "        recompiled_abi_version, 0x%016" PRIx64 "u, %zuu, entries\n};\n\n", checksum,
+            entries.size());
+    std::fprintf(file, "extern \"C\" const Recompiled_Module *ciel_recompiled_module()\n{\n    return &module;\n}\n");
+
+    std::fclose(file);
+
+    printf("[Tracer] Wrote %u code bytes as %u recompiled routines to \"%s\"\n", code_bytes, routines, path);
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef CIEL_CODE_TRACER_H
+#define CIEL_CODE_TRACER_H
+
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+enum Byte_Kind
+{
+    DataByte,
+    OpcodeByte,
+    OperandByte
+};
+
+enum Label_Kind
+{
+    NoLabel,
+    LocalLabel,
+    SubroutineLabel,
+    VectorLabel
+};
+
+class Cartridge;
+
+// follows the NROM program from its vectors and writes a cycle-annotated listing of code and data, or the code as C++
+// for a module the instruction-stepped core runs in place of interpreting it
+class Code_Tracer
+{
+private:
+    std::unique_ptr<Cartridge> cart;
+
+    // indexed by address - 8000h, 16 KiB PRG-ROM is only traced in its C000h mirror
+    std::vector<uint8_t> kinds;
+    std::vector<uint8_t> labels;
+    std::vector<uint16_t> unresolved_jumps;
+
+    uint16_t prg_base;
+    uint32_t code_bytes;
+    uint32_t subroutines;
+
+    [[nodiscard]] uint16_t fold(uint16_t address) const;
+    [[nodiscard]] uint8_t read_prg(uint16_t address) const;
+    [[nodiscard]] uint16_t read_vector(uint16_t address) const;
+
+    void add_label(uint16_t address, Label_Kind kind);
+    void trace(uint16_t entry);
+    [[nodiscard]] bool trace_program();
+
+    void write_label(std::FILE *file, uint16_t address) const;
+    void write_instruction(std::FILE *file, uint16_t address) const;
+    void write_data(std::FILE *file, uint16_t address, uint32_t end) const;
+
+    [[nodiscard]] bool is_recompiled(uint32_t address) const;
+    [[nodiscard]] uint32_t jump_target(uint16_t address) const;
+    void write_operation(std::FILE *file, uint16_t address, uint16_t start, uint32_t end) const;
+    void write_routine(std::FILE *file, uint16_t start, uint32_t end) const;
+public:
+    explicit Code_Tracer(const char *cartridge_path);
+    ~Code_Tracer();
+
+    void write_listing(const char *path);
+    void write_module(const char *path);
+};
+
+
+#endif //CIEL_CODE_TRACER_H
@@ -1,2706 +1,1747 @@
 #include "cpu.h"
 
+#include "disassembler.h"
+#include "..//scheduler.h"
 #include "..//mmu/mmu.h"
 
+#include <cinttypes>
+#include <stdexcept>
+
+const CPU::Instruction_Handler *const CPU::instruction_table[256] = {
+        // 0h, ...
+        step_sequence<&CPU::skip_padding_byte, &CPU::push_pch, &CPU::push_pcl, &CPU::push_status<0x10u>,
+                &CPU::read_vector_low<0xfffeu>, &CPU::read_vector_high<0xffffu>>,
+        read_steps<IndexedIndirect, &CPU::logical_or>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPage, &CPU::logical_or>(),
+        read_modify_write_steps<ZeroPage, &CPU::logical_shift_left>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::implied, &CPU::push_status<0x30u>>, read_steps<Immediate, &CPU::logical_or>(),
+        step_sequence<&CPU::asl>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<Absolute, &CPU::logical_or>(),
+        read_modify_write_steps<Absolute, &CPU::logical_shift_left>(), step_sequence<&CPU::unknown_opcode>,
+        // 10h, ...
+        branch_steps<Negative, false>(), read_steps<IndirectIndexed, &CPU::logical_or>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::logical_or>(),
+        read_modify_write_steps<ZeroPageX, &CPU::logical_shift_left>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::clc>, read_steps<AbsoluteY, &CPU::logical_or>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::logical_or>(),
+        read_modify_write_steps<AbsoluteX, &CPU::logical_shift_left>(), step_sequence<&CPU::unknown_opcode>,
+        // 20h, ...
+        step_sequence<&CPU::fetch_address_low, &CPU::internal_operation, &CPU::push_pch, &CPU::push_pcl, &CPU::jump>,
+        read_steps<IndexedIndirect, &CPU::logical_and>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<ZeroPage, &CPU::bit_test>(), read_steps<ZeroPage, &CPU::logical_and>(),
+        read_modify_write_steps<ZeroPage, &CPU::rotate_left>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::implied, &CPU::increment_stack_pointer, &CPU::pull_status<false>>,
+        read_steps<Immediate, &CPU::logical_and>(),
+        step_sequence<&CPU::rol>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<Absolute, &CPU::bit_test>(), read_steps<Absolute, &CPU::logical_and>(),
+        read_modify_write_steps<Absolute, &CPU::rotate_left>(), step_sequence<&CPU::unknown_opcode>,
+        // 30h, ...
+        branch_steps<Negative, true>(), read_steps<IndirectIndexed, &CPU::logical_and>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::logical_and>(),
+        read_modify_write_steps<ZeroPageX, &CPU::rotate_left>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::sec>, read_steps<AbsoluteY, &CPU::logical_and>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::logical_and>(),
+        read_modify_write_steps<AbsoluteX, &CPU::rotate_left>(), step_sequence<&CPU::unknown_opcode>,
+        // 40h, ...
+        step_sequence<&CPU::implied, &CPU::increment_stack_pointer, &CPU::pull_status<true>, &CPU::pull_pcl,
+                &CPU::pull_pch>,
+        read_steps<IndexedIndirect, &CPU::logical_xor>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPage, &CPU::logical_xor>(),
+        read_modify_write_steps<ZeroPage, &CPU::logical_shift_right>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::implied, &CPU::push_accumulator>, read_steps<Immediate, &CPU::logical_xor>(),
+        step_sequence<&CPU::lsr>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::fetch_address_low, &CPU::jump>, read_steps<Absolute, &CPU::logical_xor>(),
+        read_modify_write_steps<Absolute, &CPU::logical_shift_right>(), step_sequence<&CPU::unknown_opcode>,
+        // 50h, ...
+        branch_steps<Overflow, false>(), read_steps<IndirectIndexed, &CPU::logical_xor>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::logical_xor>(),
+        read_modify_write_steps<ZeroPageX, &CPU::logical_shift_right>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteY, &CPU::logical_xor>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::logical_xor>(),
+        read_modify_write_steps<AbsoluteX, &CPU::logical_shift_right>(), step_sequence<&CPU::unknown_opcode>,
+        // 60h, ...
+        step_sequence<&CPU::implied, &CPU::increment_stack_pointer, &CPU::pull_pcl, &CPU::pull_pch, &CPU::increment_pc>,
+        read_steps<IndexedIndirect, &CPU::add_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPage, &CPU::add_with_carry>(),
+        read_modify_write_steps<ZeroPage, &CPU::rotate_right>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::implied, &CPU::increment_stack_pointer, &CPU::pull_accumulator>,
+        read_steps<Immediate, &CPU::add_with_carry>(),
+        step_sequence<&CPU::ror>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::fetch_address_low, &CPU::fetch_address_high, &CPU::read_indirect_low,
+                &CPU::read_indirect_high>,
+        read_steps<Absolute, &CPU::add_with_carry>(),
+        read_modify_write_steps<Absolute, &CPU::rotate_right>(), step_sequence<&CPU::unknown_opcode>,
+        // 70h, ...
+        branch_steps<Overflow, true>(), read_steps<IndirectIndexed, &CPU::add_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::add_with_carry>(),
+        read_modify_write_steps<ZeroPageX, &CPU::rotate_right>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::sei>, read_steps<AbsoluteY, &CPU::add_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::add_with_carry>(),
+        read_modify_write_steps<AbsoluteX, &CPU::rotate_right>(), step_sequence<&CPU::unknown_opcode>,
+        // 80h, ...
+        step_sequence<&CPU::unknown_opcode>, store_steps<IndexedIndirect, &CPU_Registers::a>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        store_steps<ZeroPage, &CPU_Registers::y>(), store_steps<ZeroPage, &CPU_Registers::a>(),
+        store_steps<ZeroPage, &CPU_Registers::x>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::dey>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::txa>, step_sequence<&CPU::unknown_opcode>,
+        store_steps<Absolute, &CPU_Registers::y>(), store_steps<Absolute, &CPU_Registers::a>(),
+        store_steps<Absolute, &CPU_Registers::x>(), step_sequence<&CPU::unknown_opcode>,
+        // 90h, ...
+        branch_steps<Carry, false>(), store_steps<IndirectIndexed, &CPU_Registers::a>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        store_steps<ZeroPageX, &CPU_Registers::y>(), store_steps<ZeroPageX, &CPU_Registers::a>(),
+        store_steps<ZeroPageY, &CPU_Registers::x>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::tya>, store_steps<AbsoluteY, &CPU_Registers::a>(),
+        step_sequence<&CPU::txs>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, store_steps<AbsoluteX, &CPU_Registers::a>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        // A0h, ...
+        read_steps<Immediate, &CPU::load<&CPU_Registers::y>>(),
+        read_steps<IndexedIndirect, &CPU::load<&CPU_Registers::a>>(),
+        read_steps<Immediate, &CPU::load<&CPU_Registers::x>>(), step_sequence<&CPU::unknown_opcode>,
+        read_steps<ZeroPage, &CPU::load<&CPU_Registers::y>>(), read_steps<ZeroPage, &CPU::load<&CPU_Registers::a>>(),
+        read_steps<ZeroPage, &CPU::load<&CPU_Registers::x>>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::tay>, read_steps<Immediate, &CPU::load<&CPU_Registers::a>>(),
+        step_sequence<&CPU::tax>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<Absolute, &CPU::load<&CPU_Registers::y>>(), read_steps<Absolute, &CPU::load<&CPU_Registers::a>>(),
+        read_steps<Absolute, &CPU::load<&CPU_Registers::x>>(), step_sequence<&CPU::unknown_opcode>,
+        // B0h, ...
+        branch_steps<Carry, true>(), read_steps<IndirectIndexed, &CPU::load<&CPU_Registers::a>>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<ZeroPageX, &CPU::load<&CPU_Registers::y>>(), read_steps<ZeroPageX, &CPU::load<&CPU_Registers::a>>(),
+        read_steps<ZeroPageY, &CPU::load<&CPU_Registers::x>>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::clv>, read_steps<AbsoluteY, &CPU::load<&CPU_Registers::a>>(),
+        step_sequence<&CPU::tsx>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<AbsoluteX, &CPU::load<&CPU_Registers::y>>(), read_steps<AbsoluteX, &CPU::load<&CPU_Registers::a>>(),
+        read_steps<AbsoluteY, &CPU::load<&CPU_Registers::x>>(), step_sequence<&CPU::unknown_opcode>,
+        // C0h, ...
+        read_steps<Immediate, &CPU::compare<&CPU_Registers::y>>(),
+        read_steps<IndexedIndirect, &CPU::compare<&CPU_Registers::a>>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<ZeroPage, &CPU::compare<&CPU_Registers::y>>(),
+        read_steps<ZeroPage, &CPU::compare<&CPU_Registers::a>>(),
+        read_modify_write_steps<ZeroPage, &CPU::decrement>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::iny>, read_steps<Immediate, &CPU::compare<&CPU_Registers::a>>(),
+        step_sequence<&CPU::dex>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<Absolute, &CPU::compare<&CPU_Registers::y>>(),
+        read_steps<Absolute, &CPU::compare<&CPU_Registers::a>>(),
+        read_modify_write_steps<Absolute, &CPU::decrement>(), step_sequence<&CPU::unknown_opcode>,
+        // D0h, ...
+        branch_steps<Zero, false>(), read_steps<IndirectIndexed, &CPU::compare<&CPU_Registers::a>>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::compare<&CPU_Registers::a>>(),
+        read_modify_write_steps<ZeroPageX, &CPU::decrement>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::cld>, read_steps<AbsoluteY, &CPU::compare<&CPU_Registers::a>>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::compare<&CPU_Registers::a>>(),
+        read_modify_write_steps<AbsoluteX, &CPU::decrement>(), step_sequence<&CPU::unknown_opcode>,
+        // E0h, ...
+        read_steps<Immediate, &CPU::compare<&CPU_Registers::x>>(),
+        read_steps<IndexedIndirect, &CPU::subtract_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<ZeroPage, &CPU::compare<&CPU_Registers::x>>(), read_steps<ZeroPage, &CPU::subtract_with_carry>(),
+        read_modify_write_steps<ZeroPage, &CPU::increment>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::inx>, read_steps<Immediate, &CPU::subtract_with_carry>(),
+        step_sequence<&CPU::nop_imp>, step_sequence<&CPU::unknown_opcode>,
+        read_steps<Absolute, &CPU::compare<&CPU_Registers::x>>(), read_steps<Absolute, &CPU::subtract_with_carry>(),
+        read_modify_write_steps<Absolute, &CPU::increment>(), step_sequence<&CPU::unknown_opcode>,
+        // F0h, ...
+        branch_steps<Zero, true>(), read_steps<IndirectIndexed, &CPU::subtract_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<ZeroPageX, &CPU::subtract_with_carry>(),
+        read_modify_write_steps<ZeroPageX, &CPU::increment>(), step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::sed>, read_steps<AbsoluteY, &CPU::subtract_with_carry>(),
+        step_sequence<&CPU::unknown_opcode>, step_sequence<&CPU::unknown_opcode>,
+        step_sequence<&CPU::unknown_opcode>, read_steps<AbsoluteX, &CPU::subtract_with_carry>(),
+        read_modify_write_steps<AbsoluteX, &CPU::increment>(), step_sequence<&CPU::unknown_opcode>
+};
+
+// the instructions run_instruction has whole handlers for, the rest are stepped through their cycles
+const CPU::Instruction_Handler CPU::whole_instruction_table[256] = {
+        // 0h, ...
+        nullptr, &CPU::read_instruction<IndexedIndirect, &CPU::logical_or>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPage, &CPU::logical_or>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::logical_shift_left>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::logical_or>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<Absolute, &CPU::logical_or>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::logical_shift_left>, nullptr,
+        // 10h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::logical_or>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::logical_or>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::logical_shift_left>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::logical_or>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::logical_or>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::logical_shift_left>, nullptr,
+        // 20h, ...
+        nullptr, &CPU::read_instruction<IndexedIndirect, &CPU::logical_and>,
+        nullptr, nullptr,
+        &CPU::read_instruction<ZeroPage, &CPU::bit_test>, &CPU::read_instruction<ZeroPage, &CPU::logical_and>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::rotate_left>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::logical_and>,
+        nullptr, nullptr,
+        &CPU::read_instruction<Absolute, &CPU::bit_test>, &CPU::read_instruction<Absolute, &CPU::logical_and>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::rotate_left>, nullptr,
+        // 30h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::logical_and>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::logical_and>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::rotate_left>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::logical_and>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::logical_and>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::rotate_left>, nullptr,
+        // 40h, ...
+        nullptr, &CPU::read_instruction<IndexedIndirect, &CPU::logical_xor>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPage, &CPU::logical_xor>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::logical_shift_right>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::logical_xor>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<Absolute, &CPU::logical_xor>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::logical_shift_right>, nullptr,
+        // 50h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::logical_xor>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::logical_xor>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::logical_shift_right>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::logical_xor>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::logical_xor>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::logical_shift_right>, nullptr,
+        // 60h, ...
+        nullptr, &CPU::read_instruction<IndexedIndirect, &CPU::add_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPage, &CPU::add_with_carry>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::rotate_right>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::add_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<Absolute, &CPU::add_with_carry>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::rotate_right>, nullptr,
+        // 70h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::add_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::add_with_carry>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::rotate_right>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::add_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::add_with_carry>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::rotate_right>, nullptr,
+        // 80h, ...
+        nullptr, &CPU::store_instruction<IndexedIndirect, &CPU_Registers::a>,
+        nullptr, nullptr,
+        &CPU::store_instruction<ZeroPage, &CPU_Registers::y>, &CPU::store_instruction<ZeroPage, &CPU_Registers::a>,
+        &CPU::store_instruction<ZeroPage, &CPU_Registers::x>, nullptr,
+        nullptr, nullptr,
+        nullptr, nullptr,
+        &CPU::store_instruction<Absolute, &CPU_Registers::y>, &CPU::store_instruction<Absolute, &CPU_Registers::a>,
+        &CPU::store_instruction<Absolute, &CPU_Registers::x>, nullptr,
+        // 90h, ...
+        nullptr, &CPU::store_instruction<IndirectIndexed, &CPU_Registers::a>,
+        nullptr, nullptr,
+        &CPU::store_instruction<ZeroPageX, &CPU_Registers::y>, &CPU::store_instruction<ZeroPageX, &CPU_Registers::a>,
+        &CPU::store_instruction<ZeroPageY, &CPU_Registers::x>, nullptr,
+        nullptr, &CPU::store_instruction<AbsoluteY, &CPU_Registers::a>,
+        nullptr, nullptr,
+        nullptr, &CPU::store_instruction<AbsoluteX, &CPU_Registers::a>,
+        nullptr, nullptr,
+        // A0h, ...
+        &CPU::read_instruction<Immediate, &CPU::load<&CPU_Registers::y>>, &CPU::read_instruction<IndexedIndirect, &CPU::load<&CPU_Registers::a>>,
+        &CPU::read_instruction<Immediate, &CPU::load<&CPU_Registers::x>>, nullptr,
+        &CPU::read_instruction<ZeroPage, &CPU::load<&CPU_Registers::y>>, &CPU::read_instruction<ZeroPage, &CPU::load<&CPU_Registers::a>>,
+        &CPU::read_instruction<ZeroPage, &CPU::load<&CPU_Registers::x>>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::load<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        &CPU::read_instruction<Absolute, &CPU::load<&CPU_Registers::y>>, &CPU::read_instruction<Absolute, &CPU::load<&CPU_Registers::a>>,
+        &CPU::read_instruction<Absolute, &CPU::load<&CPU_Registers::x>>, nullptr,
+        // B0h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::load<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        &CPU::read_instruction<ZeroPageX, &CPU::load<&CPU_Registers::y>>, &CPU::read_instruction<ZeroPageX, &CPU::load<&CPU_Registers::a>>,
+        &CPU::read_instruction<ZeroPageY, &CPU::load<&CPU_Registers::x>>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::load<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        &CPU::read_instruction<AbsoluteX, &CPU::load<&CPU_Registers::y>>, &CPU::read_instruction<AbsoluteX, &CPU::load<&CPU_Registers::a>>,
+        &CPU::read_instruction<AbsoluteY, &CPU::load<&CPU_Registers::x>>, nullptr,
+        // C0h, ...
+        &CPU::read_instruction<Immediate, &CPU::compare<&CPU_Registers::y>>, &CPU::read_instruction<IndexedIndirect, &CPU::compare<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        &CPU::read_instruction<ZeroPage, &CPU::compare<&CPU_Registers::y>>, &CPU::read_instruction<ZeroPage, &CPU::compare<&CPU_Registers::a>>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::decrement>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::compare<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        &CPU::read_instruction<Absolute, &CPU::compare<&CPU_Registers::y>>, &CPU::read_instruction<Absolute, &CPU::compare<&CPU_Registers::a>>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::decrement>, nullptr,
+        // D0h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::compare<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::compare<&CPU_Registers::a>>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::decrement>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::compare<&CPU_Registers::a>>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::compare<&CPU_Registers::a>>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::decrement>, nullptr,
+        // E0h, ...
+        &CPU::read_instruction<Immediate, &CPU::compare<&CPU_Registers::x>>, &CPU::read_instruction<IndexedIndirect, &CPU::subtract_with_carry>,
+        nullptr, nullptr,
+        &CPU::read_instruction<ZeroPage, &CPU::compare<&CPU_Registers::x>>, &CPU::read_instruction<ZeroPage, &CPU::subtract_with_carry>,
+        &CPU::read_modify_write_instruction<ZeroPage, &CPU::increment>, nullptr,
+        nullptr, &CPU::read_instruction<Immediate, &CPU::subtract_with_carry>,
+        nullptr, nullptr,
+        &CPU::read_instruction<Absolute, &CPU::compare<&CPU_Registers::x>>, &CPU::read_instruction<Absolute, &CPU::subtract_with_carry>,
+        &CPU::read_modify_write_instruction<Absolute, &CPU::increment>, nullptr,
+        // F0h, ...
+        nullptr, &CPU::read_instruction<IndirectIndexed, &CPU::subtract_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<ZeroPageX, &CPU::subtract_with_carry>,
+        &CPU::read_modify_write_instruction<ZeroPageX, &CPU::increment>, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteY, &CPU::subtract_with_carry>,
+        nullptr, nullptr,
+        nullptr, &CPU::read_instruction<AbsoluteX, &CPU::subtract_with_carry>,
+        &CPU::read_modify_write_instruction<AbsoluteX, &CPU::increment>, nullptr
+};
+
+constexpr uint8_t max_block_length = 32;
+
+static_assert(recompiled_clock_divider == cpu_clock_divider, "Recompiled code advances the master clock like run_block");
+
 CPU::CPU(const std::shared_ptr<MMU> &mmu) :
-regs(), i_cycle(0), operand(0), effective_addr(0), cycles(7), page_boundary_crossed(false), service_nmi(false), is_running(true)
+decode_cache(0x1000), decoded(nullptr), block_cache(0x8000), recompiled_routines(), recompiled_context(),
+recompiled_generation(0), recompiled_cycles(0), regs(), frame(), instruction_pc(0), i_cycle(0), cycles(7), n_result(0), z_result(1),
+dma_byte(0), dma_lo(0), dma_elapsed(0), trace_file(nullptr)
 {
     this->mmu = mmu;
 
-    regs.p = 0x24;
+    set_status(0x24);
     regs.sp = 0xfd;
     regs.pc.hi_lo.pcl = read_memory(0xfffc);
     regs.pc.hi_lo.pch = read_memory(0xfffd);
 }
 
 CPU::~CPU()
-= default;
-
-void CPU::tick()
-{
-    ++i_cycle;
-    ++cycles;
-}
-
-void CPU::reset_ticks()
-{
-    i_cycle = -1;
-}
-
-/* void CPU::dump_registers() const
-{
-    printf("    A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%lu\n",
-            regs.a, regs.x, regs.y, regs.p, regs.sp, cycles + 1);
-} */
-
-bool CPU::is_flag_set(const CPU_Flags flag) const
-{
-    return (regs.p & flag) != 0;
-}
-
-void CPU::clear_flag(const CPU_Flags flag)
-{
-    regs.p &= (uint8_t)(~flag);
-}
-
-void CPU::set_flag(const CPU_Flags flag)
-{
-    regs.p |= flag;
-}
-
-void CPU::check_nz(const uint8_t value)
-{
-    (value == 0) ? set_flag(Zero) : clear_flag(Zero);
-    (value > 127) ? set_flag(Negative) : clear_flag(Negative);
-}
-
-uint8_t CPU::read_memory(const uint16_t address) const
 {
-    return mmu->read_byte(address);
+    if (trace_file != nullptr)
+    {
+        std::fclose(trace_file);
+    }
 }
 
-void CPU::write_memory(const uint8_t byte, const uint16_t address)
+uint16_t CPU::get_instruction_pc() const
 {
-    mmu->write_byte(byte, address);
+    return instruction_pc;
 }
 
-uint8_t CPU::pull_stack() const
+uint64_t CPU::get_cycles() const
 {
-    return read_memory(0x100u | regs.sp);
+    return cycles;
 }
 
-void CPU::push_stack(const uint8_t byte)
+uint64_t CPU::get_recompiled_cycles() const
 {
-    write_memory(byte, 0x100u | regs.sp--);
+    return recompiled_cycles;
 }
 
-void CPU::oam_dma()
+uint8_t CPU::idle_loop_cycles() const
 {
-    static uint8_t byte;
-    static uint8_t lo = 0;
-    static uint16_t elapsed = 0;
+    const uint16_t pc = regs.pc.pc;
 
-    switch (elapsed % 2)
+    // only loops in PRG-ROM are considered, fetching their bytes has no side effects
+    if (i_cycle != 0 || trace_file != nullptr || pc < 0x8000u || pc > 0xfffbu)
     {
-        case 0:
-            byte = read_memory((uint16_t)(mmu->oam_hi << 8u) | lo);
-            ++lo;
-            break;
-        case 1:
-            write_memory(byte, 0x2004);
-            break;
+        return 0;
     }
 
-    ++elapsed;
+    const uint8_t loop_opcode = read_memory(pc);
 
-    if (elapsed == 513)
+    switch (loop_opcode)
     {
-        mmu->oam_dma = false;
-        lo = 0;
-        elapsed = 0;
+        case 0x4cu: // JMP *
+            return ((read_memory(pc + 2u) << 8u) | read_memory(pc + 1u)) == pc ? opcode_table[0x4cu].cycles : 0;
+        case 0x2cu: // BIT $2002, BPL *-3
+        case 0xadu: // LDA $2002, BPL *-3
+            if (read_memory(pc + 1u) == 0x02u && read_memory(pc + 2u) == 0x20u &&
+                read_memory(pc + 3u) == 0x10u && read_memory(pc + 4u) == 0xfbu)
+            {
+                // the branch is taken, and takes another cycle if it goes back to the previous page
+                const bool page_crossed = ((pc + 5u) ^ pc) & 0xff00u;
 
-        // printf("[2A03] OAM-DMA finished\n");
+                return opcode_table[loop_opcode].cycles + opcode_table[0x10u].cycles + 1 + page_crossed;
+            }
+
+            return 0;
+        default:
+            return 0;
     }
 }
 
-void CPU::absolute(const bool store)
+uint64_t CPU::run_fused_idiom(const uint64_t cycle_budget)
 {
-    static uint8_t hi;
-    static uint8_t lo;
+    const uint16_t pc = regs.pc.pc;
 
-    switch (i_cycle)
+    if (i_cycle != 0 || trace_file != nullptr || pc < 0x8000u || pc > 0xfff6u)
     {
-        case 1:
-            lo = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            hi = read_memory(regs.pc.pc++);
-            effective_addr = (uint16_t)(hi << 8u) | lo;
-            break;
-        case 3:
-            if (!store)
-            {
-                operand = read_memory(effective_addr);
-            }
-            break;
+        return 0;
     }
-}
 
-void CPU::absolute_indexed(const uint8_t index, const bool store)
-{
-    static uint8_t hi;
-    static uint8_t lo;
-    static uint16_t correct_addr;
+    const uint8_t first_opcode = read_memory(pc);
+    uint8_t CPU_Registers::*counter = (first_opcode == 0xcau || first_opcode == 0x9du) ? &CPU_Registers::x : &CPU_Registers::y;
+    const uint8_t count_opcode = (counter == &CPU_Registers::x) ? 0xcau : 0x88u;
+    bool stores = false;
+    uint16_t base = 0;
+    uint8_t length;
+    uint8_t body_cycles;
+    uint8_t step = 0xffu;
 
-    switch (i_cycle)
+    switch (first_opcode)
     {
-        case 1:
-            page_boundary_crossed = false;
-            lo = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            hi = read_memory(regs.pc.pc++);
-            correct_addr = ((uint16_t)(hi << 8u) | lo) + index;
-            lo += index;
-            effective_addr = (uint16_t)(hi << 8u) | lo;
+        case 0x88u: // DEY, BNE *-1
+        case 0xcau: // DEX, BNE *-1
+            if (read_memory(pc + 1u) != 0xd0u || read_memory(pc + 2u) != 0xfdu)
+            {
+                return 0;
+            }
+
+            length = 3;
+            body_cycles = opcode_table[first_opcode].cycles;
             break;
-        case 3:
-            operand = read_memory(effective_addr);
+        case 0x99u: // STA abs,Y, DEY, BNE *-6
+        case 0x9du: // STA abs,X, DEX, BNE *-6 or STA abs,X, INX x4, BNE *-9
+            base = (uint16_t)(read_memory(pc + 2u) << 8u) | read_memory(pc + 1u);
 
-            if (effective_addr != correct_addr)
+            // every store and dummy read has to hit internal RAM, which nothing else observes
+            if (base + 0xffu >= 0x2000u)
             {
-                page_boundary_crossed = true;
-                effective_addr += 0x100u;
+                return 0;
             }
-            break;
-        case 4:
-            if (!store)
+
+            if (read_memory(pc + 3u) == count_opcode && read_memory(pc + 4u) == 0xd0u && read_memory(pc + 5u) == 0xfau)
+            {
+                length = 6;
+                body_cycles = opcode_table[first_opcode].cycles + opcode_table[count_opcode].cycles;
+            }
+            else if (first_opcode == 0x9du && read_memory(pc + 3u) == 0xe8u && read_memory(pc + 4u) == 0xe8u &&
+                     read_memory(pc + 5u) == 0xe8u && read_memory(pc + 6u) == 0xe8u &&
+                     read_memory(pc + 7u) == 0xd0u && read_memory(pc + 8u) == 0xf7u)
+            {
+                length = 9;
+                body_cycles = opcode_table[0x9du].cycles + 4 * opcode_table[0xe8u].cycles;
+                step = 4;
+            }
+            else
             {
-                operand = read_memory(effective_addr);
+                return 0;
             }
 
-            page_boundary_crossed = false;
+            stores = true;
             break;
+        default:
+            return 0;
     }
-}
 
-void CPU::immediate()
-{
-    operand = read_memory(regs.pc.pc++);
-}
+    // counting up by 4 only ends on zero from a multiple of 4
+    if (step == 4 && (regs.*counter & 3u) != 0)
+    {
+        return 0;
+    }
 
-void CPU::implied() const
-{
-    static uint8_t dummy;
+    uint16_t iterations = (step == 4) ? (256u - regs.*counter) / 4u : regs.*counter;
 
-    dummy = read_memory(regs.pc.pc);
-}
+    if (iterations == 0)
+    {
+        iterations = 256;
+    }
 
-void CPU::indexed_indirect(const bool store)
-{
-    static uint8_t dummy;
-    static uint8_t hi;
-    static uint8_t lo;
-    static uint8_t pointer;
+    const uint8_t taken_cycles = body_cycles + opcode_table[0xd0u].cycles + 1 + ((((pc + length) ^ pc) & 0xff00u) != 0);
+    const uint8_t exit_cycles = body_cycles + opcode_table[0xd0u].cycles;
 
-    switch (i_cycle)
+    uint16_t runs = iterations;
+    uint64_t total_cycles = (uint64_t)(iterations - 1u) * taken_cycles + exit_cycles;
+
+    // stop short of the budget on a taken branch, the interpreter picks the loop up from there
+    if (total_cycles > cycle_budget)
     {
-        case 1:
-            pointer = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            dummy = read_memory(pointer);
-            pointer += regs.x;
-            break;
-        case 3:
-            lo = read_memory(pointer++);
-            break;
-        case 4:
-            hi = read_memory(pointer);
-            effective_addr = (uint16_t)(hi << 8u) | lo;
-            break;
-        case 5:
-            if (!store)
-            {
-                operand = read_memory(effective_addr);
-            }
-            break;
+        runs = cycle_budget / taken_cycles;
+        total_cycles = (uint64_t)runs * taken_cycles;
     }
-}
 
-void CPU::indirect_indexed(const bool store)
-{
-    static uint8_t hi;
-    static uint8_t lo;
-    static uint8_t pointer;
-    static uint16_t correct_addr;
+    if (runs == 0)
+    {
+        return 0;
+    }
 
-    switch (i_cycle)
+    for (uint16_t run = 0; run < runs; run++)
     {
-        case 1:
-            page_boundary_crossed = false;
-            pointer = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            lo = read_memory(pointer++);
-            break;
-        case 3:
-            hi = read_memory(pointer);
-            correct_addr = ((uint16_t)(hi << 8u) | lo) + regs.y;
-            lo += regs.y;
-            effective_addr = (uint16_t)(hi << 8u) | lo;
-            break;
-        case 4:
-            operand = read_memory(effective_addr);
+        if (stores)
+        {
+            write_memory(regs.a, base + regs.*counter);
+        }
 
-            if (effective_addr != correct_addr)
-            {
-                page_boundary_crossed = true;
-                effective_addr += 0x100u;
-            }
-            break;
-        case 5:
-            if (!store)
-            {
-                operand = read_memory(effective_addr);
-            }
+        regs.*counter += step;
+    }
 
-            page_boundary_crossed = false;
-            break;
+    check_nz(regs.*counter);
 
+    if (runs == iterations)
+    {
+        regs.pc.pc += length;
     }
+
+    cycles += total_cycles;
+
+    return total_cycles;
 }
 
-void CPU::zero_page(const bool store)
+void CPU::skip_cycles(const uint64_t count)
 {
-    switch (i_cycle)
-    {
-        case 1:
-            effective_addr = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            if (!store)
-            {
-                operand = read_memory(effective_addr);
-            }
-            break;
-    }
+    cycles += count;
 }
 
-void CPU::zero_page_indexed(const uint8_t index, const bool store)
+void CPU::enable_trace(const char *path)
 {
-    static uint8_t dummy;
-    static uint8_t zero_page_address;
+    trace_file = std::fopen(path, "w");
 
-    switch (i_cycle)
+    if (trace_file == nullptr)
     {
-        case 1:
-            zero_page_address = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            dummy = read_memory(zero_page_address);
-            zero_page_address += index;
-            effective_addr = zero_page_address;
-            break;
-        case 3:
-            if (!store)
-            {
-                operand = read_memory(effective_addr);
-            }
-            break;
+        throw std::runtime_error("[2A03] Couldn't open trace file!");
     }
+
+    printf("[2A03] Tracing instructions to \"%s\"\n", path);
 }
 
-void CPU::add_with_carry(const uint8_t value)
+void CPU::attach_recompiled(const Recompiled_Module *module)
 {
-    uint16_t result = regs.a + value + (regs.p & 0x1u);
+    if (module->abi_version != recompiled_abi_version)
+    {
+        throw std::runtime_error("[2A03] Recompiled module was built for another version of the core!");
+    }
 
-    (result > 255) ? set_flag(Carry) : clear_flag(Carry);
-    check_nz((uint8_t)result);
-    (((regs.a & 0x80u) == (value & 0x80u)) && ((regs.a & 0x80u) != (result & 0x80u))) ?
-    set_flag(Overflow) : clear_flag(Overflow);
+    uint64_t checksum = recompiled_hash_seed;
 
-    regs.a = (uint8_t)result;
+    for (uint32_t address = 0x8000; address <= 0xffff; address++)
+    {
+        checksum = recompiled_hash(checksum, read_memory(address));
+    }
+
+    if (checksum != module->prg_checksum)
+    {
+        throw std::runtime_error("[2A03] Recompiled module was built for another PRG-ROM!");
+    }
+
+    recompiled_routines.assign(0x8000, nullptr);
+
+    for (uint32_t entry = 0; entry < module->entry_count; entry++)
+    {
+        if (module->entries[entry].pc >= 0x8000u)
+        {
+            recompiled_routines[module->entries[entry].pc - 0x8000u] = module->entries[entry].routine;
+        }
+    }
+
+    recompiled_generation = mmu->prg_generation;
+
+    recompiled_context.read_pages = mmu->get_read_pages();
+    recompiled_context.write_pages = mmu->get_write_pages();
+    recompiled_context.read_io = &CPU::read_recompiled_io;
+    recompiled_context.write_io = &CPU::write_recompiled_io;
+    recompiled_context.run_oam_dma = &CPU::run_recompiled_oam_dma;
+    recompiled_context.cpu = this;
+    recompiled_context.nmi_pending = &mmu->nmi_pending;
+    recompiled_context.oam_dma = &mmu->oam_dma;
+
+    printf("[2A03] Running PRG-ROM code from %u recompiled entry points\n", module->entry_count);
 }
 
-void CPU::bit_test()
+void CPU::tick()
 {
-    uint8_t result = regs.a & operand;
-
-    (result == 0) ? set_flag(Zero) : clear_flag(Zero);
-    ((operand & 0x40u) != 0) ? set_flag(Overflow) : clear_flag(Overflow);
-    ((operand & 0x80u) != 0) ? set_flag(Negative) : clear_flag(Negative);
+    ++i_cycle;
+    ++cycles;
 }
 
-void CPU::branch(const bool condition)
+void CPU::trace_instruction(const uint16_t pc) const
 {
-    static int8_t relative_offset;
-    static uint16_t correct_addr;
+    const uint8_t length = instruction_length(opcode_table[frame.opcode].mode);
+    uint8_t bytes[3] = { frame.opcode, 0, 0 };
+    char machine_code[10] = "";
+    char assembly[16];
 
-    switch (i_cycle)
+    for (uint8_t byte = 0; byte < length; byte++)
     {
-        case 1:
-            relative_offset = (int8_t)read_memory(regs.pc.pc++);
+        if (byte != 0)
+        {
+            bytes[byte] = (decoded != nullptr) ? decoded->bytes[byte] : read_memory(pc + byte);
+        }
 
-            if (!condition)
-            {
-                reset_ticks();
-            }
-            break;
-        case 2:
-            correct_addr = regs.pc.pc + relative_offset;
-            regs.pc.hi_lo.pcl += relative_offset;
+        std::snprintf(machine_code + 3 * byte, sizeof(machine_code) - 3 * byte, "%02X ", bytes[byte]);
+    }
 
-            if (regs.pc.pc == correct_addr)
-            {
-                reset_ticks();
-            }
-            break;
-        case 3:
-            (regs.pc.pc > correct_addr) ? --regs.pc.hi_lo.pch : ++regs.pc.hi_lo.pch;
+    machine_code[3 * length - 1] = '\0';
+    disassemble(pc, bytes, assembly, sizeof(assembly));
 
-            reset_ticks();
-            break;
-    }
+    std::fprintf(trace_file, "%04X  %-8s  %-11s  A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%" PRIu64 "\n",
+            pc, machine_code, assembly, regs.a, regs.x, regs.y, get_status(), regs.sp, cycles);
 }
 
-void CPU::compare(const uint8_t reg)
+bool CPU::is_flag_set(const CPU_Flags flag) const
 {
-    uint8_t result = reg - operand;
-
-    (reg >= operand) ? set_flag(Carry) : clear_flag(Carry);
-    (result == 0) ? set_flag(Zero) : clear_flag(Zero);
-    ((result & 0x80u) != 0) ? set_flag(Negative) : clear_flag(Negative);
+    switch (flag)
+    {
+        case Zero:
+            return z_result == 0;
+        case Negative:
+            return (n_result & 0x80u) != 0;
+        default:
+            return (regs.p & flag) != 0;
+    }
 }
 
-void CPU::decrement(uint8_t &reg)
+void CPU::clear_flag(const CPU_Flags flag)
 {
-    --reg;
-
-    check_nz(reg);
+    regs.p &= (uint8_t)(~flag);
 }
 
-void CPU::increment(uint8_t &reg)
+void CPU::set_flag(const CPU_Flags flag)
 {
-    ++reg;
-
-    check_nz(reg);
+    regs.p |= flag;
 }
 
-void CPU::load_register(uint8_t &reg)
+void CPU::check_nz(const uint8_t value)
 {
-    reg = operand;
-
-    check_nz(reg);
+    n_result = value;
+    z_result = value;
 }
 
-void CPU::logical_and()
+uint8_t CPU::get_status() const
 {
-    regs.a &= operand;
-
-    check_nz(regs.a);
+    return (regs.p & (uint8_t)(~(Zero | Negative))) | ((z_result == 0) ? Zero : 0) | (n_result & Negative);
 }
 
-void CPU::logical_or()
+void CPU::set_status(const uint8_t status)
 {
-    regs.a |= operand;
-
-    check_nz(regs.a);
+    regs.p = status;
+    n_result = status & Negative;
+    z_result = ~status & Zero;
 }
 
-void CPU::logical_shift_left(uint8_t &reg)
+const CPU::Decoded_Instruction *CPU::decode(const uint16_t pc)
 {
-    bool carry = (reg & 0x80u) != 0;
-
-    reg <<= 1u;
-    regs.p = (regs.p & 0xfeu) | carry;
+    // mapper writes are the only way to change PRG-ROM, and they bump the generation
+    if (pc < 0x8000u || pc > 0xfffdu)
+    {
+        return nullptr;
+    }
 
-    check_nz(reg);
-}
+    Decoded_Instruction &entry = decode_cache[pc & (decode_cache.size() - 1u)];
 
-void CPU::logical_shift_right(uint8_t &reg)
-{
-    bool carry = (reg & 0x1u) != 0;
+    if (entry.pc != pc || entry.prg_generation != mmu->prg_generation)
+    {
+        entry.prg_generation = mmu->prg_generation;
+        entry.pc = pc;
 
-    reg >>= 1u;
-    regs.p = (regs.p & 0xfeu) | carry;
+        for (uint8_t byte = 0; byte < 3; byte++)
+        {
+            entry.bytes[byte] = read_memory(pc + byte);
+        }
+    }
 
-    (reg == 0) ? set_flag(Zero) : clear_flag(Zero);
-    clear_flag(Negative);
+    return &entry;
 }
 
-void CPU::logical_xor()
+const CPU::Translated_Block *CPU::translate(const uint16_t pc)
 {
-    regs.a ^= operand;
+    // code in RAM can be rewritten at any time, so only PRG-ROM is translated
+    if (pc < 0x8000u)
+    {
+        return nullptr;
+    }
 
-    check_nz(regs.a);
-}
+    Translated_Block &block = block_cache[pc - 0x8000u];
 
-void CPU::non_maskable_interrupt()
-{
-    static uint8_t dummy;
+    if (!block.instructions.empty() && block.pc == pc && block.pages[0] == mmu->get_read_page(pc) &&
+        block.pages[1] == mmu->get_read_page(block.end))
+    {
+        return &block;
+    }
+
+    block.pc = pc;
+    block.instructions.clear();
+
+    uint32_t address = pc;
 
-    switch (i_cycle)
+    while (block.instructions.size() < max_block_length)
     {
-        case 1:
-            --regs.pc.pc;
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            push_stack(regs.pc.hi_lo.pch);
-            break;
-        case 3:
-            push_stack(regs.pc.hi_lo.pcl);
-            break;
-        case 4:
-            push_stack(regs.p);
-            break;
-        case 5:
-            regs.pc.hi_lo.pcl = read_memory(0xfffa);
+        const uint8_t opcode = read_memory(address);
+        const Opcode_Info &info = opcode_table[opcode];
+        const uint8_t length = instruction_length(info.mode);
+
+        if (address + length > 0x10000u)
+        {
             break;
-        case 6:
-            regs.pc.hi_lo.pch = read_memory(0xfffb);
-            service_nmi = false;
+        }
 
-            reset_ticks();
+        Translated_Instruction &instruction = block.instructions.emplace_back();
+
+        instruction.decoded.prg_generation = mmu->prg_generation;
+        instruction.decoded.pc = address;
+        instruction.handler = whole_instruction_table[opcode];
+
+        for (uint8_t byte = 0; byte < 3; byte++)
+        {
+            instruction.decoded.bytes[byte] = (byte < length) ? read_memory(address + byte) : 0;
+        }
+
+        address += length;
+
+        // anything that can leave the straight line ends the block, and so do unknown opcodes
+        if (info.mode == Relative || info.cycles == 0 || opcode == 0x00u || opcode == 0x20u || opcode == 0x40u ||
+            opcode == 0x4cu || opcode == 0x60u || opcode == 0x6cu)
+        {
             break;
+        }
     }
+
+    if (block.instructions.empty())
+    {
+        return nullptr;
+    }
+
+    block.end = address - 1u;
+    block.pages[0] = mmu->get_read_page(pc);
+    block.pages[1] = mmu->get_read_page(block.end);
+
+    // pages read through the mapper give no way to tell a bank switch happened
+    if (block.pages[0] == nullptr || block.pages[1] == nullptr)
+    {
+        block.instructions.clear();
+        return nullptr;
+    }
+
+    return &block;
 }
 
-void CPU::rotate_left(uint8_t &reg)
+uint8_t CPU::read_instruction_byte() const
 {
-    bool carry = (reg & 0x80u) != 0;
-
-    reg <<= 1u;
-    reg |= (regs.p & 0x1u);
-    regs.p = (regs.p & 0xfeu) | carry;
+    if (decoded != nullptr)
+    {
+        return decoded->bytes[(uint16_t)(regs.pc.pc - decoded->pc)];
+    }
 
-    check_nz(reg);
+    return read_memory(regs.pc.pc);
 }
 
-void CPU::rotate_right(uint8_t &reg)
+uint8_t CPU::fetch_instruction_byte()
 {
-    bool carry = (reg & 0x1u) != 0;
+    const uint8_t byte = read_instruction_byte();
 
-    reg >>= 1u;
-    reg |= ((regs.p & 0x1u) << 7u);
-    regs.p = (regs.p & 0xfeu) | carry;
+    ++regs.pc.pc;
 
-    check_nz(reg);
+    return byte;
 }
 
-void CPU::software_interrupt()
+uint8_t CPU::read_memory(const uint16_t address) const
 {
-    static uint8_t dummy;
-
-    switch (i_cycle)
-    {
-        case 1:
-            dummy = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            push_stack(regs.pc.hi_lo.pch);
-            break;
-        case 3:
-            push_stack(regs.pc.hi_lo.pcl);
-            break;
-        case 4:
-            push_stack(regs.p | 0x10u);
-            break;
-        case 5:
-            regs.pc.hi_lo.pcl = read_memory(0xfffe);
-            break;
-        case 6:
-            regs.pc.hi_lo.pch = read_memory(0xffff);
-            reset_ticks();
-            break;
-    }
+    return mmu->read_byte(address);
 }
 
-void CPU::store_register(const uint8_t reg)
+void CPU::write_memory(const uint8_t byte, const uint16_t address)
 {
-    write_memory(reg, effective_addr);
+    mmu->write_byte(byte, address);
 }
 
-void CPU::transfer(const uint8_t source, uint8_t &target, const bool txs)
+uint8_t CPU::pull_stack() const
 {
-    implied();
-
-    target = source;
-
-    if (!txs)
-    {
-        check_nz(target);
-    }
-
-    reset_ticks();
+    return read_memory(0x100u | regs.sp);
 }
 
-void CPU::adc_abs()
+void CPU::push_stack(const uint8_t byte)
 {
-    absolute();
+    write_memory(byte, 0x100u | regs.sp--);
+}
 
-    if (i_cycle == 3)
+void CPU::oam_dma()
+{
+    switch (dma_elapsed % 2)
     {
-        add_with_carry(operand);
-        reset_ticks();
+        case 0:
+            dma_byte = read_memory((uint16_t)(mmu->oam_hi << 8u) | dma_lo);
+            ++dma_lo;
+            break;
+        case 1:
+            write_memory(dma_byte, 0x2004);
+            break;
     }
-}
 
-void CPU::adc_abx()
-{
-    absolute_indexed(regs.x);
+    ++dma_elapsed;
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
+    if (dma_elapsed == 513)
     {
-        add_with_carry(operand);
-        reset_ticks();
+        mmu->oam_dma = false;
+        dma_lo = 0;
+        dma_elapsed = 0;
+
+        // printf("[2A03] OAM-DMA finished\n");
     }
 }
 
-void CPU::adc_aby()
+void CPU::skip_steps()
 {
-    absolute_indexed(regs.y);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        add_with_carry(operand);
-        reset_ticks();
-    }
+    frame.resume = step_sequence<>;
 }
 
-void CPU::adc_imm()
+void CPU::implied()
 {
-    immediate();
-    add_with_carry(operand);
-    reset_ticks();
+    (void)read_instruction_byte();
 }
 
-void CPU::adc_izx()
+void CPU::fetch_zero_page()
 {
-    indexed_indirect();
+    frame.effective_addr = fetch_instruction_byte();
+}
 
-    if (i_cycle == 5)
-    {
-        add_with_carry(operand);
-        reset_ticks();
-    }
+void CPU::fetch_pointer()
+{
+    frame.pointer = fetch_instruction_byte();
 }
 
-void CPU::adc_izy()
+void CPU::fetch_address_low()
 {
-    indirect_indexed();
+    frame.addr_lo = fetch_instruction_byte();
+}
 
-    if (i_cycle >= 4 && !page_boundary_crossed)
-    {
-        add_with_carry(operand);
-        reset_ticks();
-    }
+void CPU::fetch_address_high()
+{
+    frame.addr_hi = fetch_instruction_byte();
+    frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
 }
 
-void CPU::adc_zpa()
+template <uint8_t CPU_Registers::*index>
+void CPU::fetch_address_high_indexed()
 {
-    zero_page();
+    frame.addr_hi = fetch_instruction_byte();
+    frame.correct_addr = ((uint16_t)(frame.addr_hi << 8u) | frame.addr_lo) + regs.*index;
+    frame.addr_lo += regs.*index;
+    frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
+}
 
-    if (i_cycle == 2)
-    {
-        add_with_carry(operand);
-        reset_ticks();
-    }
+template <uint8_t CPU_Registers::*index>
+void CPU::index_zero_page()
+{
+    (void)read_memory(frame.pointer);
+    frame.pointer += regs.*index;
+    frame.effective_addr = frame.pointer;
 }
 
-void CPU::adc_zpx()
+void CPU::index_pointer()
 {
-    zero_page_indexed(regs.x);
+    (void)read_memory(frame.pointer);
+    frame.pointer += regs.x;
+}
 
-    if (i_cycle == 3)
-    {
-        add_with_carry(operand);
-        reset_ticks();
-    }
+void CPU::read_pointer_low()
+{
+    frame.addr_lo = read_memory(frame.pointer++);
 }
 
-void CPU::and_abs()
+void CPU::read_pointer_high()
 {
-    absolute();
+    frame.addr_hi = read_memory(frame.pointer);
+    frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
+}
 
-    if (i_cycle == 3)
-    {
-        logical_and();
-        reset_ticks();
-    }
+void CPU::read_pointer_high_indexed()
+{
+    frame.addr_hi = read_memory(frame.pointer);
+    frame.correct_addr = ((uint16_t)(frame.addr_hi << 8u) | frame.addr_lo) + regs.y;
+    frame.addr_lo += regs.y;
+    frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
 }
 
-void CPU::and_abx()
+void CPU::fix_address()
 {
-    absolute_indexed(regs.x);
+    (void)read_memory(frame.effective_addr);
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
+    if (frame.effective_addr != frame.correct_addr)
     {
-        logical_and();
-        reset_ticks();
+        frame.effective_addr += 0x100u;
     }
 }
 
-void CPU::and_aby()
+void CPU::read_operand()
 {
-    absolute_indexed(regs.y);
+    frame.operand = read_memory(frame.effective_addr);
+}
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        logical_and();
-        reset_ticks();
-    }
+void CPU::write_operand()
+{
+    write_memory(frame.operand, frame.effective_addr);
 }
 
-void CPU::and_imm()
+template <void (CPU::*operation)()>
+void CPU::operate_immediate()
 {
-    immediate();
-    logical_and();
-    reset_ticks();
+    frame.operand = fetch_instruction_byte();
+
+    (this->*operation)();
 }
 
-void CPU::and_izx()
+template <void (CPU::*operation)()>
+void CPU::operate()
 {
-    indexed_indirect();
+    frame.operand = read_memory(frame.effective_addr);
 
-    if (i_cycle == 5)
-    {
-        logical_and();
-        reset_ticks();
-    }
+    (this->*operation)();
 }
 
-void CPU::and_izy()
+template <void (CPU::*operation)()>
+void CPU::operate_unless_crossed()
 {
-    indirect_indexed();
+    frame.operand = read_memory(frame.effective_addr);
 
-    if (i_cycle >= 4 && !page_boundary_crossed)
+    // the read from the wrong page is repeated from the right one on the next step
+    if (frame.effective_addr != frame.correct_addr)
     {
-        logical_and();
-        reset_ticks();
+        frame.effective_addr += 0x100u;
+        return;
     }
+
+    (this->*operation)();
+    skip_steps();
 }
 
-void CPU::and_zpa()
+template <void (CPU::*operation)(uint8_t &)>
+void CPU::modify()
 {
-    zero_page();
+    // the unmodified value is written back while the operation runs
+    write_memory(frame.operand, frame.effective_addr);
 
-    if (i_cycle == 2)
-    {
-        logical_and();
-        reset_ticks();
-    }
+    (this->*operation)(frame.operand);
 }
 
-void CPU::and_zpx()
+template <uint8_t CPU_Registers::*reg>
+void CPU::write_register()
 {
-    zero_page_indexed(regs.x);
+    write_memory(regs.*reg, frame.effective_addr);
+}
 
-    if (i_cycle == 3)
+template <Addressing_Mode mode, CPU::Instruction_Handler... tail>
+constexpr const CPU::Instruction_Handler *CPU::address_steps()
+{
+    if constexpr (mode == ZeroPage)
+    {
+        return step_sequence<&CPU::fetch_zero_page, tail...>;
+    }
+    else if constexpr (mode == ZeroPageX)
+    {
+        return step_sequence<&CPU::fetch_pointer, &CPU::index_zero_page<&CPU_Registers::x>, tail...>;
+    }
+    else if constexpr (mode == ZeroPageY)
+    {
+        return step_sequence<&CPU::fetch_pointer, &CPU::index_zero_page<&CPU_Registers::y>, tail...>;
+    }
+    else if constexpr (mode == Absolute)
+    {
+        return step_sequence<&CPU::fetch_address_low, &CPU::fetch_address_high, tail...>;
+    }
+    else if constexpr (mode == AbsoluteX)
+    {
+        return step_sequence<&CPU::fetch_address_low, &CPU::fetch_address_high_indexed<&CPU_Registers::x>, tail...>;
+    }
+    else if constexpr (mode == AbsoluteY)
+    {
+        return step_sequence<&CPU::fetch_address_low, &CPU::fetch_address_high_indexed<&CPU_Registers::y>, tail...>;
+    }
+    else if constexpr (mode == IndexedIndirect)
+    {
+        return step_sequence<&CPU::fetch_pointer, &CPU::index_pointer, &CPU::read_pointer_low, &CPU::read_pointer_high,
+                tail...>;
+    }
+    else
     {
-        logical_and();
-        reset_ticks();
+        return step_sequence<&CPU::fetch_pointer, &CPU::read_pointer_low, &CPU::read_pointer_high_indexed, tail...>;
     }
 }
 
-void CPU::asl()
+// indexed modes can't tell whether the address needs its high byte fixed until the cycle after it is formed
+constexpr bool is_indexed(const Addressing_Mode mode)
 {
-    implied();
-    logical_shift_left(regs.a);
-    reset_ticks();
+    return mode == AbsoluteX || mode == AbsoluteY || mode == IndirectIndexed;
 }
 
-void CPU::asl_abs()
+template <Addressing_Mode mode, void (CPU::*operation)()>
+constexpr const CPU::Instruction_Handler *CPU::read_steps()
 {
-    absolute();
-
-    switch (i_cycle)
+    if constexpr (mode == Immediate)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            logical_shift_left(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        return step_sequence<&CPU::operate_immediate<operation>>;
+    }
+    else if constexpr (is_indexed(mode))
+    {
+        return address_steps<mode, &CPU::operate_unless_crossed<operation>, &CPU::operate<operation>>();
+    }
+    else
+    {
+        return address_steps<mode, &CPU::operate<operation>>();
     }
 }
 
-void CPU::asl_abx()
+template <Addressing_Mode mode, void (CPU::*operation)(uint8_t &)>
+constexpr const CPU::Instruction_Handler *CPU::read_modify_write_steps()
 {
-    absolute_indexed(regs.x);
-
-    switch (i_cycle)
+    if constexpr (is_indexed(mode))
     {
-        case 5:
-            write_memory(operand, effective_addr);
-            logical_shift_left(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        return address_steps<mode, &CPU::fix_address, &CPU::read_operand, &CPU::modify<operation>, &CPU::write_operand>();
+    }
+    else
+    {
+        return address_steps<mode, &CPU::read_operand, &CPU::modify<operation>, &CPU::write_operand>();
     }
 }
 
-void CPU::asl_zpa()
+template <Addressing_Mode mode, uint8_t CPU_Registers::*reg>
+constexpr const CPU::Instruction_Handler *CPU::store_steps()
 {
-    zero_page();
-
-    switch (i_cycle)
+    if constexpr (is_indexed(mode))
     {
-        case 3:
-            write_memory(operand, effective_addr);
-            logical_shift_left(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        return address_steps<mode, &CPU::fix_address, &CPU::write_register<reg>>();
+    }
+    else
+    {
+        return address_steps<mode, &CPU::write_register<reg>>();
     }
 }
 
-void CPU::asl_zpx()
+template <CPU_Flags flag, bool set>
+void CPU::fetch_branch_offset()
 {
-    zero_page_indexed(regs.x);
+    frame.relative_offset = (int8_t)fetch_instruction_byte();
 
-    switch (i_cycle)
+    if (is_flag_set(flag) != set)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            logical_shift_left(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        skip_steps();
     }
 }
 
-void CPU::bcc()
+void CPU::add_branch_offset()
 {
-    branch(!is_flag_set(Carry));
+    frame.correct_addr = regs.pc.pc + frame.relative_offset;
+    regs.pc.hi_lo.pcl += frame.relative_offset;
+
+    if (regs.pc.pc == frame.correct_addr)
+    {
+        skip_steps();
+    }
 }
 
-void CPU::bcs()
+void CPU::fix_branch_page()
 {
-    branch(is_flag_set(Carry));
+    (regs.pc.pc > frame.correct_addr) ? --regs.pc.hi_lo.pch : ++regs.pc.hi_lo.pch;
 }
 
-void CPU::beq()
+template <CPU_Flags flag, bool set>
+constexpr const CPU::Instruction_Handler *CPU::branch_steps()
 {
-    branch(is_flag_set(Zero));
+    return step_sequence<&CPU::fetch_branch_offset<flag, set>, &CPU::add_branch_offset, &CPU::fix_branch_page>;
 }
 
-void CPU::bit_abs()
+void CPU::internal_operation()
 {
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        bit_test();
-        reset_ticks();
-    }
 }
 
-void CPU::bit_zpa()
+void CPU::skip_padding_byte()
 {
-    zero_page();
-
-    if (i_cycle == 2)
-    {
-        bit_test();
-        reset_ticks();
-    }
+    (void)fetch_instruction_byte();
 }
 
-void CPU::bmi()
+void CPU::rewind_pc()
 {
-    branch(is_flag_set(Negative));
+    --regs.pc.pc;
+    (void)read_memory(regs.pc.pc);
 }
 
-void CPU::bne()
+void CPU::increment_pc()
 {
-    branch(!is_flag_set(Zero));
+    ++regs.pc.pc;
 }
 
-void CPU::bpl()
+void CPU::jump()
 {
-    branch(!is_flag_set(Negative));
+    regs.pc.hi_lo.pch = read_instruction_byte();
+    regs.pc.hi_lo.pcl = frame.addr_lo;
 }
 
-void CPU::bvc()
+void CPU::read_indirect_low()
 {
-    branch(!is_flag_set(Overflow));
+    regs.pc.hi_lo.pcl = read_memory((uint16_t)(frame.addr_hi << 8u) | frame.addr_lo);
+    ++frame.addr_lo;
 }
 
-void CPU::bvs()
+void CPU::read_indirect_high()
 {
-    branch(is_flag_set(Overflow));
+    regs.pc.hi_lo.pch = read_memory((uint16_t)(frame.addr_hi << 8u) | frame.addr_lo);
 }
 
-void CPU::clc()
+template <uint16_t vector>
+void CPU::read_vector_low()
 {
-    implied();
-    clear_flag(Carry);
-    reset_ticks();
+    regs.pc.hi_lo.pcl = read_memory(vector);
 }
 
-void CPU::cld()
+template <uint16_t vector>
+void CPU::read_vector_high()
 {
-    implied();
-    clear_flag(DecimalMode);
-    reset_ticks();
+    regs.pc.hi_lo.pch = read_memory(vector);
 }
 
-void CPU::clv()
+void CPU::push_pch()
 {
-    implied();
-    clear_flag(Overflow);
-    reset_ticks();
+    push_stack(regs.pc.hi_lo.pch);
 }
 
-void CPU::cmp_abs()
+void CPU::push_pcl()
 {
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        compare(regs.a);
-        reset_ticks();
-    }
+    push_stack(regs.pc.hi_lo.pcl);
 }
 
-void CPU::cmp_abx()
+void CPU::push_accumulator()
 {
-    absolute_indexed(regs.x);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        compare(regs.a);
-        reset_ticks();
-    }
+    push_stack(regs.a);
 }
 
-void CPU::cmp_aby()
+template <uint8_t flags>
+void CPU::push_status()
 {
-    absolute_indexed(regs.y);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        compare(regs.a);
-        reset_ticks();
-    }
+    push_stack(get_status() | flags);
 }
 
-void CPU::cmp_imm()
+void CPU::increment_stack_pointer()
 {
-    immediate();
-    compare(regs.a);
-    reset_ticks();
+    ++regs.sp;
 }
 
-void CPU::cmp_izx()
+void CPU::pull_accumulator()
 {
-    indexed_indirect();
+    regs.a = pull_stack();
 
-    if (i_cycle == 5)
-    {
-        compare(regs.a);
-        reset_ticks();
-    }
+    check_nz(regs.a);
 }
 
-void CPU::cmp_izy()
+template <bool advance>
+void CPU::pull_status()
 {
-    indirect_indexed();
+    set_status((regs.p & 0x30u) | (uint8_t)(pull_stack() & (uint8_t)(~0x30u)));
 
-    if (i_cycle >= 4 && !page_boundary_crossed)
+    if (advance)
     {
-        compare(regs.a);
-        reset_ticks();
+        ++regs.sp;
     }
 }
 
-void CPU::cmp_zpa()
+void CPU::pull_pcl()
 {
-    zero_page();
+    regs.pc.hi_lo.pcl = pull_stack();
+    ++regs.sp;
+}
 
-    if (i_cycle == 2)
-    {
-        compare(regs.a);
-        reset_ticks();
-    }
+void CPU::pull_pch()
+{
+    regs.pc.hi_lo.pch = pull_stack();
 }
 
-void CPU::cmp_zpx()
+void CPU::index_address_instruction(const uint8_t index, const bool store)
 {
-    zero_page_indexed(regs.x);
+    const uint16_t base = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
+
+    frame.effective_addr = base + index;
 
-    if (i_cycle == 3)
+    // the address without the carry into the high byte is read first, the fix-up costs a cycle when indexing crosses a
+    // page and is always taken by stores and read-modify-writes
+    if (store || ((base ^ frame.effective_addr) & 0xff00u) != 0)
     {
-        compare(regs.a);
-        reset_ticks();
+        (void)read_memory((base & 0xff00u) | (uint8_t)frame.effective_addr);
+        ++cycles;
     }
 }
 
-void CPU::cpx_abs()
+template <Addressing_Mode mode>
+void CPU::address_instruction(const bool store)
 {
-    absolute();
-
-    if (i_cycle == 3)
+    if constexpr (mode == ZeroPage)
     {
-        compare(regs.x);
-        reset_ticks();
+        frame.effective_addr = fetch_instruction_byte();
+        ++cycles;
     }
-}
+    else if constexpr (mode == ZeroPageX || mode == ZeroPageY)
+    {
+        frame.pointer = fetch_instruction_byte();
+        ++cycles;
 
-void CPU::cpx_imm()
-{
-    immediate();
-    compare(regs.x);
-    reset_ticks();
-}
+        (void)read_memory(frame.pointer);
+        frame.pointer += (mode == ZeroPageX) ? regs.x : regs.y;
+        frame.effective_addr = frame.pointer;
+        ++cycles;
+    }
+    else if constexpr (mode == Absolute || mode == AbsoluteX || mode == AbsoluteY)
+    {
+        frame.addr_lo = fetch_instruction_byte();
+        ++cycles;
 
-void CPU::cpx_zpa()
-{
-    zero_page();
+        frame.addr_hi = fetch_instruction_byte();
+        ++cycles;
 
-    if (i_cycle == 2)
-    {
-        compare(regs.x);
-        reset_ticks();
+        if constexpr (mode == Absolute)
+        {
+            frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
+        }
+        else
+        {
+            index_address_instruction((mode == AbsoluteX) ? regs.x : regs.y, store);
+        }
     }
-}
+    else if constexpr (mode == IndexedIndirect)
+    {
+        frame.pointer = fetch_instruction_byte();
+        ++cycles;
 
-void CPU::cpy_abs()
-{
-    absolute();
+        (void)read_memory(frame.pointer);
+        frame.pointer += regs.x;
+        ++cycles;
 
-    if (i_cycle == 3)
-    {
-        compare(regs.y);
-        reset_ticks();
+        frame.addr_lo = read_memory(frame.pointer++);
+        ++cycles;
+
+        frame.addr_hi = read_memory(frame.pointer);
+        frame.effective_addr = (uint16_t)(frame.addr_hi << 8u) | frame.addr_lo;
+        ++cycles;
     }
-}
+    else
+    {
+        frame.pointer = fetch_instruction_byte();
+        ++cycles;
 
-void CPU::cpy_imm()
-{
-    immediate();
-    compare(regs.y);
-    reset_ticks();
-}
+        frame.addr_lo = read_memory(frame.pointer++);
+        ++cycles;
 
-void CPU::cpy_zpa()
-{
-    zero_page();
+        frame.addr_hi = read_memory(frame.pointer);
+        ++cycles;
 
-    if (i_cycle == 2)
-    {
-        compare(regs.y);
-        reset_ticks();
+        index_address_instruction(regs.y, store);
     }
 }
 
-void CPU::dec_abs()
+template <Addressing_Mode mode, void (CPU::*operation)()>
+void CPU::read_instruction()
 {
-    absolute();
-
-    switch (i_cycle)
+    if constexpr (mode == Immediate)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            decrement(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        frame.operand = fetch_instruction_byte();
     }
-}
-
-void CPU::dec_abx()
-{
-    absolute_indexed(regs.x);
-
-    switch (i_cycle)
+    else
     {
-        case 5:
-            write_memory(operand, effective_addr);
-            decrement(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        address_instruction<mode>(false);
+
+        frame.operand = read_memory(frame.effective_addr);
     }
+
+    (this->*operation)();
+    ++cycles;
 }
 
-void CPU::dec_zpa()
+template <Addressing_Mode mode, void (CPU::*operation)(uint8_t &)>
+void CPU::read_modify_write_instruction()
 {
-    zero_page();
+    address_instruction<mode>(true);
+
+    frame.operand = read_memory(frame.effective_addr);
+    ++cycles;
 
-    switch (i_cycle)
+    write_memory(frame.operand, frame.effective_addr);
+    (this->*operation)(frame.operand);
+    ++cycles;
+
+    // writing the unmodified value to OAMDMA starts the DMA before the second write
+    if (mmu->oam_dma)
     {
-        case 3:
-            write_memory(operand, effective_addr);
-            decrement(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        oam_dma();
     }
+
+    write_memory(frame.operand, frame.effective_addr);
+    ++cycles;
 }
 
-void CPU::dec_zpx()
+template <Addressing_Mode mode, uint8_t CPU_Registers::*reg>
+void CPU::store_instruction()
 {
-    zero_page_indexed(regs.x);
+    address_instruction<mode>(true);
 
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            decrement(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
+    write_memory(regs.*reg, frame.effective_addr);
+    ++cycles;
 }
 
-void CPU::dex()
+void CPU::add_with_carry()
 {
-    implied();
-    decrement(regs.x);
-    reset_ticks();
+    uint16_t result = regs.a + frame.operand + (regs.p & 0x1u);
+
+    (result > 255) ? set_flag(Carry) : clear_flag(Carry);
+    check_nz((uint8_t)result);
+    (((regs.a & 0x80u) == (frame.operand & 0x80u)) && ((regs.a & 0x80u) != (result & 0x80u))) ?
+    set_flag(Overflow) : clear_flag(Overflow);
+
+    regs.a = (uint8_t)result;
 }
 
-void CPU::dey()
+void CPU::bit_test()
 {
-    implied();
-    decrement(regs.y);
-    reset_ticks();
+    z_result = regs.a & frame.operand;
+    n_result = frame.operand;
+
+    ((frame.operand & 0x40u) != 0) ? set_flag(Overflow) : clear_flag(Overflow);
 }
 
-void CPU::eor_abs()
+template <uint8_t CPU_Registers::*reg>
+void CPU::compare()
 {
-    absolute();
+    uint8_t result = regs.*reg - frame.operand;
 
-    if (i_cycle == 3)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    (regs.*reg >= frame.operand) ? set_flag(Carry) : clear_flag(Carry);
+    check_nz(result);
 }
 
-void CPU::eor_abx()
+void CPU::decrement(uint8_t &reg)
 {
-    absolute_indexed(regs.x);
+    --reg;
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    check_nz(reg);
 }
 
-void CPU::eor_aby()
+void CPU::increment(uint8_t &reg)
 {
-    absolute_indexed(regs.y);
+    ++reg;
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    check_nz(reg);
 }
 
-void CPU::eor_imm()
+template <uint8_t CPU_Registers::*reg>
+void CPU::load()
 {
-    immediate();
-    logical_xor();
-    reset_ticks();
+    regs.*reg = frame.operand;
+
+    check_nz(regs.*reg);
 }
 
-void CPU::eor_izx()
+void CPU::logical_and()
 {
-    indexed_indirect();
+    regs.a &= frame.operand;
 
-    if (i_cycle == 5)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    check_nz(regs.a);
 }
 
-void CPU::eor_izy()
+void CPU::logical_or()
 {
-    indirect_indexed();
+    regs.a |= frame.operand;
 
-    if (i_cycle >= 4 && !page_boundary_crossed)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    check_nz(regs.a);
 }
 
-void CPU::eor_zpa()
+void CPU::logical_shift_left(uint8_t &reg)
 {
-    zero_page();
+    bool carry = (reg & 0x80u) != 0;
 
-    if (i_cycle == 2)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    reg <<= 1u;
+    regs.p = (regs.p & 0xfeu) | carry;
+
+    check_nz(reg);
 }
 
-void CPU::eor_zpx()
+void CPU::logical_shift_right(uint8_t &reg)
 {
-    zero_page_indexed(regs.x);
+    bool carry = (reg & 0x1u) != 0;
 
-    if (i_cycle == 3)
-    {
-        logical_xor();
-        reset_ticks();
-    }
+    reg >>= 1u;
+    regs.p = (regs.p & 0xfeu) | carry;
+
+    check_nz(reg);
 }
 
-void CPU::inc_abs()
+void CPU::logical_xor()
 {
-    absolute();
+    regs.a ^= frame.operand;
 
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            increment(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
+    check_nz(regs.a);
 }
 
-void CPU::inc_abx()
+void CPU::rotate_left(uint8_t &reg)
 {
-    absolute_indexed(regs.x);
+    bool carry = (reg & 0x80u) != 0;
 
-    switch (i_cycle)
-    {
-        case 5:
-            write_memory(operand, effective_addr);
-            increment(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
+    reg <<= 1u;
+    reg |= (regs.p & 0x1u);
+    regs.p = (regs.p & 0xfeu) | carry;
+
+    check_nz(reg);
 }
 
-void CPU::inc_zpa()
+void CPU::rotate_right(uint8_t &reg)
 {
-    zero_page();
+    bool carry = (reg & 0x1u) != 0;
 
-    switch (i_cycle)
-    {
-        case 3:
-            write_memory(operand, effective_addr);
-            increment(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
+    reg >>= 1u;
+    reg |= ((regs.p & 0x1u) << 7u);
+    regs.p = (regs.p & 0xfeu) | carry;
+
+    check_nz(reg);
+}
+
+void CPU::subtract_with_carry()
+{
+    frame.operand = ~frame.operand;
+
+    add_with_carry();
 }
 
-void CPU::inc_zpx()
+void CPU::transfer(const uint8_t source, uint8_t &target, const bool txs)
 {
-    zero_page_indexed(regs.x);
+    implied();
+
+    target = source;
 
-    switch (i_cycle)
+    if (!txs)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            increment(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        check_nz(target);
     }
 }
 
-void CPU::inx()
+void CPU::asl()
 {
     implied();
-    increment(regs.x);
-    reset_ticks();
+    logical_shift_left(regs.a);
 }
 
-void CPU::iny()
+void CPU::clc()
 {
     implied();
-    increment(regs.y);
-    reset_ticks();
+    clear_flag(Carry);
 }
 
-void CPU::jmp_abs()
+void CPU::cld()
 {
-    static uint8_t pcl;
-
-    switch (i_cycle)
-    {
-        case 1:
-            pcl = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            regs.pc.hi_lo.pch = read_memory(regs.pc.pc);
-            regs.pc.hi_lo.pcl = pcl;
-
-            reset_ticks();
-            break;
-    }
+    implied();
+    clear_flag(DecimalMode);
 }
 
-void CPU::jmp_ind()
+void CPU::clv()
 {
-    static uint8_t pointer_hi;
-    static uint8_t pointer_lo;
-
-    switch (i_cycle)
-    {
-        case 1:
-            pointer_lo = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            pointer_hi = read_memory(regs.pc.pc++);
-            break;
-        case 3:
-            regs.pc.hi_lo.pcl = read_memory((uint16_t)(pointer_hi << 8u) | pointer_lo);
-            ++pointer_lo;
-            break;
-        case 4:
-            regs.pc.hi_lo.pch = read_memory((uint16_t)(pointer_hi << 8u) | pointer_lo);
-
-            reset_ticks();
-            break;
-    }
+    implied();
+    clear_flag(Overflow);
 }
 
-void CPU::jsr()
+void CPU::dex()
 {
-    static uint8_t pcl;
-
-    switch (i_cycle)
-    {
-        case 1:
-            pcl = read_memory(regs.pc.pc++);
-            break;
-        case 2:
-            // internal operation?
-            break;
-        case 3:
-            push_stack(regs.pc.hi_lo.pch);
-            break;
-        case 4:
-            push_stack(regs.pc.hi_lo.pcl);
-            break;
-        case 5:
-            regs.pc.hi_lo.pch = read_memory(regs.pc.pc);
-            regs.pc.hi_lo.pcl = pcl;
-
-            reset_ticks();
-            break;
-    }
+    implied();
+    decrement(regs.x);
 }
 
-void CPU::lda_abs()
+void CPU::dey()
 {
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    decrement(regs.y);
 }
 
-void CPU::lda_abx()
+void CPU::inx()
 {
-    absolute_indexed(regs.x);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    increment(regs.x);
 }
 
-void CPU::lda_aby()
+void CPU::iny()
 {
-    absolute_indexed(regs.y);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    increment(regs.y);
 }
 
-void CPU::lda_imm()
+void CPU::lsr()
 {
-    immediate();
-
-    load_register(regs.a);
-    reset_ticks();
+    implied();
+    logical_shift_right(regs.a);
 }
 
-void CPU::lda_izx()
+void CPU::nop_imp()
 {
-    indexed_indirect();
-
-    if (i_cycle == 5)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
 }
 
-void CPU::lda_izy()
+void CPU::rol()
 {
-    indirect_indexed();
-
-    if (i_cycle >= 4 && !page_boundary_crossed)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    rotate_left(regs.a);
 }
 
-void CPU::lda_zpa()
+void CPU::ror()
 {
-    zero_page();
-
-    if (i_cycle == 2)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    rotate_right(regs.a);
 }
 
-void CPU::lda_zpx()
+void CPU::sec()
 {
-    zero_page_indexed(regs.x);
-
-    if (i_cycle == 3)
-    {
-        load_register(regs.a);
-        reset_ticks();
-    }
+    implied();
+    set_flag(Carry);
 }
 
-void CPU::ldx_abs()
+void CPU::sed()
 {
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        load_register(regs.x);
-        reset_ticks();
-    }
+    implied();
+    set_flag(DecimalMode);
 }
 
-void CPU::ldx_aby()
+void CPU::sei()
 {
-    absolute_indexed(regs.y);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        load_register(regs.x);
-        reset_ticks();
-    }
+    implied();
+    set_flag(InterruptDisable);
 }
 
-void CPU::ldx_imm()
+void CPU::tax()
 {
-    immediate();
-
-    load_register(regs.x);
-    reset_ticks();
+    transfer(regs.a, regs.x);
 }
 
-void CPU::ldx_zpa()
+void CPU::tay()
 {
-    zero_page();
-
-    if (i_cycle == 2)
-    {
-        load_register(regs.x);
-        reset_ticks();
-    }
+    transfer(regs.a, regs.y);
 }
 
-void CPU::ldx_zpy()
+void CPU::tsx()
 {
-    zero_page_indexed(regs.y);
-
-    if (i_cycle == 3)
-    {
-        load_register(regs.x);
-        reset_ticks();
-    }
+    transfer(regs.sp, regs.x);
 }
 
-void CPU::ldy_abs()
+void CPU::txa()
 {
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        load_register(regs.y);
-        reset_ticks();
-    }
+    transfer(regs.x, regs.a);
 }
 
-void CPU::ldy_abx()
+void CPU::txs()
 {
-    absolute_indexed(regs.x);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        load_register(regs.y);
-        reset_ticks();
-    }
+    transfer(regs.x, regs.sp, true);
 }
 
-void CPU::ldy_imm()
+void CPU::tya()
 {
-    immediate();
-
-    load_register(regs.y);
-    reset_ticks();
+    transfer(regs.y, regs.a);
 }
 
-void CPU::ldy_zpa()
+void CPU::unknown_opcode()
 {
-    zero_page();
-
-    if (i_cycle == 2)
-    {
-        load_register(regs.y);
-        reset_ticks();
-    }
+    mmu->raise_fault(UnknownOpcode, instruction_pc, frame.opcode);
 }
 
-void CPU::ldy_zpx()
+void CPU::begin_instruction(const Decoded_Instruction *instruction)
 {
-    zero_page_indexed(regs.x);
+    instruction_pc = regs.pc.pc;
+    decoded = instruction;
+    frame.opcode = fetch_instruction_byte();
+    frame.resume = instruction_table[frame.opcode];
 
-    if (i_cycle == 3)
+    if (mmu->nmi_pending)
     {
-        load_register(regs.y);
-        reset_ticks();
+        // printf("[2A03] NMI acknowledged!\n");
+
+        frame.resume = step_sequence<&CPU::rewind_pc, &CPU::push_pch, &CPU::push_pcl, &CPU::push_status<0>,
+                &CPU::read_vector_low<0xfffau>, &CPU::read_vector_high<0xfffbu>>;
+        mmu->nmi_pending = false;
+    }
+    else if (trace_file != nullptr)
+    {
+        trace_instruction(instruction_pc);
     }
-}
 
-void CPU::lsr()
-{
-    implied();
-    logical_shift_right(regs.a);
-    reset_ticks();
+    tick();
 }
 
-void CPU::lsr_abs()
+void CPU::finish_instruction(const Instruction_Handler handler)
 {
-    absolute();
-
-    switch (i_cycle)
+    if (handler != nullptr)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            logical_shift_right(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
+        (this->*handler)();
 
-void CPU::lsr_abx()
-{
-    absolute_indexed(regs.x);
+        i_cycle = 0;
+        return;
+    }
 
-    switch (i_cycle)
+    do
     {
-        case 5:
-            write_memory(operand, effective_addr);
-            logical_shift_right(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
+        run_cycle();
+    } while (i_cycle != 0);
 }
 
-void CPU::lsr_zpa()
+void CPU::run_cycle()
 {
-    zero_page();
-
-    switch (i_cycle)
+    if (mmu->oam_dma)
     {
-        case 3:
-            write_memory(operand, effective_addr);
-            logical_shift_right(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        // printf("[2A03] OAM-DMA\n");
+        oam_dma();
     }
-}
-
-void CPU::lsr_zpx()
-{
-    zero_page_indexed(regs.x);
 
-    switch (i_cycle)
+    if (i_cycle == 0)
     {
-        case 4:
-            write_memory(operand, effective_addr);
-            logical_shift_right(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
+        begin_instruction(decode(regs.pc.pc));
+        return;
     }
-}
 
-void CPU::nop_imp()
-{
-    implied();
-    reset_ticks();
-}
+    (this->*(*frame.resume++))();
 
-void CPU::ora_abs()
-{
-    absolute();
+    tick();
 
-    if (i_cycle == 3)
+    // the instruction is over once its steps run out
+    if (*frame.resume == nullptr)
     {
-        logical_or();
-        reset_ticks();
+        i_cycle = 0;
     }
 }
 
-void CPU::ora_abx()
+uint8_t CPU::run_instruction()
 {
-    absolute_indexed(regs.x);
+    const uint64_t start_cycles = cycles;
+    Instruction_Handler handler = nullptr;
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
+    // OAM-DMA runs alongside the CPU a cycle at a time, so instructions are only run at once when there is none
+    if (i_cycle == 0 && !mmu->oam_dma)
     {
-        logical_or();
-        reset_ticks();
-    }
-}
+        const bool interrupted = mmu->nmi_pending;
 
-void CPU::ora_aby()
-{
-    absolute_indexed(regs.y);
+        begin_instruction(decode(regs.pc.pc));
 
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        logical_or();
-        reset_ticks();
+        if (!interrupted)
+        {
+            handler = whole_instruction_table[frame.opcode];
+        }
     }
-}
 
-void CPU::ora_imm()
-{
-    immediate();
-    logical_or();
-    reset_ticks();
+    finish_instruction(handler);
+
+    return cycles - start_cycles;
 }
 
-void CPU::ora_izx()
+uint8_t CPU::read_recompiled_io(Recompiled_Context *context, const uint16_t address, const uint16_t pc)
 {
-    indexed_indirect();
+    CPU *cpu = (CPU *)context->cpu;
 
-    if (i_cycle == 5)
-    {
-        logical_or();
-        reset_ticks();
-    }
+    cpu->cycles = context->cycles;
+    cpu->instruction_pc = pc;
+
+    return cpu->read_memory(address);
 }
 
-void CPU::ora_izy()
+void CPU::write_recompiled_io(Recompiled_Context *context, const uint8_t byte, const uint16_t address,
+                              const uint16_t pc)
 {
-    indirect_indexed();
+    CPU *cpu = (CPU *)context->cpu;
 
-    if (i_cycle >= 4 && !page_boundary_crossed)
-    {
-        logical_or();
-        reset_ticks();
-    }
+    cpu->cycles = context->cycles;
+    cpu->instruction_pc = pc;
+
+    cpu->write_memory(byte, address);
 }
 
-void CPU::ora_zpa()
+void CPU::run_recompiled_oam_dma(Recompiled_Context *context)
 {
-    zero_page();
+    CPU *cpu = (CPU *)context->cpu;
 
-    if (i_cycle == 2)
-    {
-        logical_or();
-        reset_ticks();
-    }
+    cpu->cycles = context->cycles;
+
+    cpu->oam_dma();
 }
 
-void CPU::ora_zpx()
+void CPU::run_recompiled(Scheduler &scheduler)
 {
-    zero_page_indexed(regs.x);
+    Recompiled_Context &context = recompiled_context;
+    uint16_t pc = regs.pc.pc;
 
-    if (i_cycle == 3)
+    context.a = regs.a;
+    context.x = regs.x;
+    context.y = regs.y;
+    context.p = regs.p;
+    context.sp = regs.sp;
+    context.n_result = n_result;
+    context.z_result = z_result;
+    context.cycles = cycles;
+    context.master_clock = &scheduler.master_clock;
+    context.next_deadline = &scheduler.next_deadline;
+
+    // routines hand over to each other until one ends up where there is no code, or the emulator has to take over
+    do
     {
-        logical_or();
-        reset_ticks();
-    }
+        pc = recompiled_routines[pc - 0x8000u](&context, pc);
+    } while (pc >= 0x8000u && recompiled_routines[pc - 0x8000u] != nullptr &&
+             scheduler.master_clock < scheduler.next_deadline && !mmu->nmi_pending && !mmu->oam_dma &&
+             mmu->prg_generation == recompiled_generation);
+
+    regs.a = context.a;
+    regs.x = context.x;
+    regs.y = context.y;
+    regs.p = context.p;
+    regs.sp = context.sp;
+    regs.pc.pc = pc;
+    n_result = context.n_result;
+    z_result = context.z_result;
+    recompiled_cycles += context.cycles - cycles;
+    cycles = context.cycles;
 }
 
-void CPU::pha()
+void CPU::run_block(Scheduler &scheduler)
 {
-    static uint8_t dummy;
+    const Translated_Block *block = nullptr;
 
-    switch (i_cycle)
+    // interrupts and DMAs are left to run_instruction
+    if (i_cycle == 0 && !mmu->oam_dma && !mmu->nmi_pending)
     {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            push_stack(regs.a);
-            reset_ticks();
-            break;
-    }
-}
+        // recompiled code only stands in for the PRG-ROM it was built from, and it isn't traced
+        if (regs.pc.pc >= 0x8000u && !recompiled_routines.empty() && trace_file == nullptr &&
+            recompiled_routines[regs.pc.pc - 0x8000u] != nullptr && mmu->prg_generation == recompiled_generation)
+        {
+            run_recompiled(scheduler);
+            return;
+        }
 
-void CPU::php()
-{
-    static uint8_t dummy;
+        block = translate(regs.pc.pc);
+    }
 
-    switch (i_cycle)
+    if (block == nullptr)
     {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            push_stack(regs.p | 0x30u);
-            reset_ticks();
-            break;
+        scheduler.master_clock += cpu_clock_divider * run_instruction();
+        return;
     }
-}
 
-void CPU::pla()
-{
-    static uint8_t dummy;
+    const uint32_t prg_generation = mmu->prg_generation;
 
-    switch (i_cycle)
+    for (const Translated_Instruction &instruction : block->instructions)
     {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            ++regs.sp;
-            break;
-        case 3:
-            regs.a = pull_stack();
-
-            check_nz(regs.a);
-            reset_ticks();
-            break;
-    }
-}
+        const uint64_t start_cycles = cycles;
 
-void CPU::plp()
-{
-    static uint8_t dummy;
+        begin_instruction(&instruction.decoded);
+        finish_instruction(instruction.handler);
 
-    switch (i_cycle)
-    {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            ++regs.sp;
-            break;
-        case 3:
-            regs.p = (regs.p & 0x30u) | (uint8_t)(pull_stack() & (uint8_t)(~0x30u));
+        scheduler.master_clock += cpu_clock_divider * (cycles - start_cycles);
 
-            reset_ticks();
-            break;
+        // the rest of the block waits for due events, interrupts and DMAs, or is gone after a bank switch
+        if (scheduler.master_clock >= scheduler.next_deadline || mmu->nmi_pending || mmu->oam_dma ||
+            mmu->prg_generation != prg_generation)
+        {
+            return;
+        }
     }
-}
-
-void CPU::rol()
-{
-    implied();
-    rotate_left(regs.a);
-    reset_ticks();
-}
-
-void CPU::rol_abs()
-{
-    absolute();
-
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            rotate_left(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::rol_abx()
-{
-    absolute_indexed(regs.x);
-
-    switch (i_cycle)
-    {
-        case 5:
-            write_memory(operand, effective_addr);
-            rotate_left(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::rol_zpa()
-{
-    zero_page();
-
-    switch (i_cycle)
-    {
-        case 3:
-            write_memory(operand, effective_addr);
-            rotate_left(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::rol_zpx()
-{
-    zero_page_indexed(regs.x);
-
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            rotate_left(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::ror()
-{
-    implied();
-    rotate_right(regs.a);
-    reset_ticks();
-}
-
-void CPU::ror_abs()
-{
-    absolute();
-
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            rotate_right(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::ror_abx()
-{
-    absolute_indexed(regs.x);
-
-    switch (i_cycle)
-    {
-        case 5:
-            write_memory(operand, effective_addr);
-            rotate_right(operand);
-            break;
-        case 6:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::ror_zpa()
-{
-    zero_page();
-
-    switch (i_cycle)
-    {
-        case 3:
-            write_memory(operand, effective_addr);
-            rotate_right(operand);
-            break;
-        case 4:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::ror_zpx()
-{
-    zero_page_indexed(regs.x);
-
-    switch (i_cycle)
-    {
-        case 4:
-            write_memory(operand, effective_addr);
-            rotate_right(operand);
-            break;
-        case 5:
-            write_memory(operand, effective_addr);
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::rti()
-{
-    static uint8_t dummy;
-
-    switch (i_cycle)
-    {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            ++regs.sp;
-            break;
-        case 3:
-            regs.p = (regs.p & 0x30u) | (uint8_t)(pull_stack() & (uint8_t)(~0x30u));
-            ++regs.sp;
-            break;
-        case 4:
-            regs.pc.hi_lo.pcl = pull_stack();
-            ++regs.sp;
-            break;
-        case 5:
-            regs.pc.hi_lo.pch = pull_stack();
-
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::rts()
-{
-    static uint8_t dummy;
-
-    switch (i_cycle)
-    {
-        case 1:
-            dummy = read_memory(regs.pc.pc);
-            break;
-        case 2:
-            ++regs.sp;
-            break;
-        case 3:
-            regs.pc.hi_lo.pcl = pull_stack();
-            ++regs.sp;
-            break;
-        case 4:
-            regs.pc.hi_lo.pch = pull_stack();
-            break;
-        case 5:
-            ++regs.pc.pc;
-
-            reset_ticks();
-            break;
-    }
-}
-
-void CPU::sbc_abs()
-{
-    absolute();
-
-    if (i_cycle == 3)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_abx()
-{
-    absolute_indexed(regs.x);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_aby()
-{
-    absolute_indexed(regs.y);
-
-    if (i_cycle >= 3 && !page_boundary_crossed)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_imm()
-{
-    immediate();
-    add_with_carry(~operand);
-    reset_ticks();
-}
-
-void CPU::sbc_izx()
-{
-    indexed_indirect();
-
-    if (i_cycle == 5)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_izy()
-{
-    indirect_indexed();
-
-    if (i_cycle >= 4 && !page_boundary_crossed)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_zpa()
-{
-    zero_page();
-
-    if (i_cycle == 2)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sbc_zpx()
-{
-    zero_page_indexed(regs.x);
-
-    if (i_cycle == 3)
-    {
-        add_with_carry(~operand);
-        reset_ticks();
-    }
-}
-
-void CPU::sec()
-{
-    implied();
-    set_flag(Carry);
-    reset_ticks();
-}
-
-void CPU::sed()
-{
-    implied();
-    set_flag(DecimalMode);
-    reset_ticks();
-}
-
-void CPU::sei()
-{
-    implied();
-    set_flag(InterruptDisable);
-    reset_ticks();
-}
-
-void CPU::sta_abs()
-{
-    absolute(true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_abx()
-{
-    absolute_indexed(regs.x, true);
-
-    if (i_cycle == 4)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_aby()
-{
-    absolute_indexed(regs.y, true);
-
-    if (i_cycle == 4)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_izx()
-{
-    indexed_indirect(true);
-
-    if (i_cycle == 5)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_izy()
-{
-    indirect_indexed(true);
-
-    if (i_cycle == 5)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_zpa()
-{
-    zero_page(true);
-
-    if (i_cycle == 2)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::sta_zpx()
-{
-    zero_page_indexed(regs.x, true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.a);
-        reset_ticks();
-    }
-}
-
-void CPU::stx_abs()
-{
-    absolute(true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.x);
-        reset_ticks();
-    }
-}
-
-void CPU::stx_zpa()
-{
-    zero_page(true);
-
-    if (i_cycle == 2)
-    {
-        store_register(regs.x);
-        reset_ticks();
-    }
-}
-
-void CPU::stx_zpy()
-{
-    zero_page_indexed(regs.y, true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.x);
-        reset_ticks();
-    }
-}
-
-void CPU::sty_abs()
-{
-    absolute(true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.y);
-        reset_ticks();
-    }
-}
-
-void CPU::sty_zpa()
-{
-    zero_page(true);
-
-    if (i_cycle == 2)
-    {
-        store_register(regs.y);
-        reset_ticks();
-    }
-}
-
-void CPU::sty_zpx()
-{
-    zero_page_indexed(regs.x, true);
-
-    if (i_cycle == 3)
-    {
-        store_register(regs.y);
-        reset_ticks();
-    }
-}
-
-void CPU::tax()
-{
-    transfer(regs.a, regs.x);
-}
-
-void CPU::tay()
-{
-    transfer(regs.a, regs.y);
-}
-
-void CPU::tsx()
-{
-    transfer(regs.sp, regs.x);
-}
-
-void CPU::txa()
-{
-    transfer(regs.x, regs.a);
-}
-
-void CPU::txs()
-{
-    transfer(regs.x, regs.sp, true);
-}
-
-void CPU::tya()
-{
-    transfer(regs.y, regs.a);
-}
-
-void CPU::run_cycle()
-{
-    static uint8_t opcode;
-
-    if (mmu->oam_dma)
-    {
-        // printf("[2A03] OAM-DMA\n");
-        oam_dma();
-    }
-
-    if (i_cycle == 0)
-    {
-        opcode = read_memory(regs.pc.pc++);
-
-        if (mmu->nmi_pending)
-        {
-            // printf("[2A03] NMI acknowledged!\n");
-
-            service_nmi = true;
-            mmu->nmi_pending = false;
-        }
-
-        tick();
-        return;
-    }
-
-    if (service_nmi)
-    {
-        non_maskable_interrupt();
-        tick();
-        return;
-    }
-
-    switch (opcode)
-    {
-        case 0x00:
-            software_interrupt();
-            break;
-        case 0x01:
-            ora_izx();
-            break;
-        case 0x05:
-            ora_zpa();
-            break;
-        case 0x06:
-            asl_zpa();
-            break;
-        case 0x08:
-            php();
-            break;
-        case 0x09:
-            ora_imm();
-            break;
-        case 0x0a:
-            asl();
-            break;
-        case 0x0d:
-            ora_abs();
-            break;
-        case 0x0e:
-            asl_abs();
-            break;
-        case 0x10:
-            bpl();
-            break;
-        case 0x11:
-            ora_izy();
-            break;
-        case 0x15:
-            ora_zpx();
-            break;
-        case 0x16:
-            asl_zpx();
-            break;
-        case 0x18:
-            clc();
-            break;
-        case 0x19:
-            ora_aby();
-            break;
-        case 0x1d:
-            ora_abx();
-            break;
-        case 0x1e:
-            asl_abx();
-            break;
-        case 0x20:
-            jsr();
-            break;
-        case 0x21:
-            and_izx();
-            break;
-        case 0x24:
-            bit_zpa();
-            break;
-        case 0x25:
-            and_zpa();
-            break;
-        case 0x26:
-            rol_zpa();
-            break;
-        case 0x28:
-            plp();
-            break;
-        case 0x29:
-            and_imm();
-            break;
-        case 0x2a:
-            rol();
-            break;
-        case 0x2c:
-            bit_abs();
-            break;
-        case 0x2d:
-            and_abs();
-            break;
-        case 0x2e:
-            rol_abs();
-            break;
-        case 0x30:
-            bmi();
-            break;
-        case 0x31:
-            and_izy();
-            break;
-        case 0x35:
-            and_zpx();
-            break;
-        case 0x36:
-            rol_zpx();
-            break;
-        case 0x38:
-            sec();
-            break;
-        case 0x39:
-            and_aby();
-            break;
-        case 0x3d:
-            and_abx();
-            break;
-        case 0x3e:
-            rol_abx();
-            break;
-        case 0x40:
-            rti();
-            break;
-        case 0x41:
-            eor_izx();
-            break;
-        case 0x45:
-            eor_zpa();
-            break;
-        case 0x46:
-            lsr_zpa();
-            break;
-        case 0x48:
-            pha();
-            break;
-        case 0x49:
-            eor_imm();
-            break;
-        case 0x4a:
-            lsr();
-            break;
-        case 0x4c:
-            jmp_abs();
-            break;
-        case 0x4d:
-            eor_abs();
-            break;
-        case 0x4e:
-            lsr_abs();
-            break;
-        case 0x50:
-            bvc();
-            break;
-        case 0x51:
-            eor_izy();
-            break;
-        case 0x56:
-            lsr_zpx();
-            break;
-        case 0x55:
-            eor_zpx();
-            break;
-        case 0x59:
-            eor_aby();
-            break;
-        case 0x5d:
-            eor_abx();
-            break;
-        case 0x5e:
-            lsr_abx();
-            break;
-        case 0x60:
-            rts();
-            break;
-        case 0x61:
-            adc_izx();
-            break;
-        case 0x65:
-            adc_zpa();
-            break;
-        case 0x66:
-            ror_zpa();
-            break;
-        case 0x68:
-            pla();
-            break;
-        case 0x69:
-            adc_imm();
-            break;
-        case 0x6a:
-            ror();
-            break;
-        case 0x6c:
-            jmp_ind();
-            break;
-        case 0x6d:
-            adc_abs();
-            break;
-        case 0x6e:
-            ror_abs();
-            break;
-        case 0x70:
-            bvs();
-            break;
-        case 0x71:
-            adc_izy();
-            break;
-        case 0x75:
-            adc_zpx();
-            break;
-        case 0x76:
-            ror_zpx();
-            break;
-        case 0x78:
-            sei();
-            break;
-        case 0x79:
-            adc_aby();
-            break;
-        case 0x7d:
-            adc_abx();
-            break;
-        case 0x7e:
-            ror_abx();
-            break;
-        case 0x81:
-            sta_izx();
-            break;
-        case 0x84:
-            sty_zpa();
-            break;
-        case 0x85:
-            sta_zpa();
-            break;
-        case 0x86:
-            stx_zpa();
-            break;
-        case 0x88:
-            dey();
-            break;
-        case 0x8a:
-            txa();
-            break;
-        case 0x8c:
-            sty_abs();
-            break;
-        case 0x8d:
-            sta_abs();
-            break;
-        case 0x8e:
-            stx_abs();
-            break;
-        case 0x90:
-            bcc();
-            break;
-        case 0x91:
-            sta_izy();
-            break;
-        case 0x94:
-            sty_zpx();
-            break;
-        case 0x95:
-            sta_zpx();
-            break;
-        case 0x96:
-            stx_zpy();
-            break;
-        case 0x98:
-            tya();
-            break;
-        case 0x99:
-            sta_aby();
-            break;
-        case 0x9a:
-            txs();
-            break;
-        case 0x9d:
-            sta_abx();
-            break;
-        case 0xa0:
-            ldy_imm();
-            break;
-        case 0xa1:
-            lda_izx();
-            break;
-        case 0xa2:
-            ldx_imm();
-            break;
-        case 0xa4:
-            ldy_zpa();
-            break;
-        case 0xa5:
-            lda_zpa();
-            break;
-        case 0xa6:
-            ldx_zpa();
-            break;
-        case 0xa8:
-            tay();
-            break;
-        case 0xa9:
-            lda_imm();
-            break;
-        case 0xaa:
-            tax();
-            break;
-        case 0xac:
-            ldy_abs();
-            break;
-        case 0xad:
-            lda_abs();
-            break;
-        case 0xae:
-            ldx_abs();
-            break;
-        case 0xb0:
-            bcs();
-            break;
-        case 0xb1:
-            lda_izy();
-            break;
-        case 0xb4:
-            ldy_zpx();
-            break;
-        case 0xb5:
-            lda_zpx();
-            break;
-        case 0xb6:
-            ldx_zpy();
-            break;
-        case 0xb8:
-            clv();
-            break;
-        case 0xb9:
-            lda_aby();
-            break;
-        case 0xba:
-            tsx();
-            break;
-        case 0xbc:
-            ldy_abx();
-            break;
-        case 0xbd:
-            lda_abx();
-            break;
-        case 0xbe:
-            ldx_aby();
-            break;
-        case 0xc0:
-            cpy_imm();
-            break;
-        case 0xc1:
-            cmp_izx();
-            break;
-        case 0xc4:
-            cpy_zpa();
-            break;
-        case 0xc5:
-            cmp_zpa();
-            break;
-        case 0xc6:
-            dec_zpa();
-            break;
-        case 0xc8:
-            iny();
-            break;
-        case 0xc9:
-            cmp_imm();
-            break;
-        case 0xca:
-            dex();
-            break;
-        case 0xcc:
-            cpy_abs();
-            break;
-        case 0xcd:
-            cmp_abs();
-            break;
-        case 0xce:
-            dec_abs();
-            break;
-        case 0xd0:
-            bne();
-            break;
-        case 0xd1:
-            cmp_izy();
-            break;
-        case 0xd5:
-            cmp_zpx();
-            break;
-        case 0xd6:
-            dec_zpx();
-            break;
-        case 0xd8:
-            cld();
-            break;
-        case 0xd9:
-            cmp_aby();
-            break;
-        case 0xdd:
-            cmp_abx();
-            break;
-        case 0xde:
-            dec_abx();
-            break;
-        case 0xe0:
-            cpx_imm();
-            break;
-        case 0xe1:
-            sbc_izx();
-            break;
-        case 0xe4:
-            cpx_zpa();
-            break;
-        case 0xe5:
-            sbc_zpa();
-            break;
-        case 0xe6:
-            inc_zpa();
-            break;
-        case 0xe8:
-            inx();
-            break;
-        case 0xe9:
-            sbc_imm();
-            break;
-        case 0xea:
-            nop_imp();
-            break;
-        case 0xec:
-            cpx_abs();
-            break;
-        case 0xed:
-            sbc_abs();
-            break;
-        case 0xee:
-            inc_abs();
-            break;
-        case 0xf0:
-            beq();
-            break;
-        case 0xf1:
-            sbc_izy();
-            break;
-        case 0xf5:
-            sbc_zpx();
-            break;
-        case 0xf6:
-            inc_zpx();
-            break;
-        case 0xf8:
-            sed();
-            break;
-        case 0xf9:
-            sbc_aby();
-            break;
-        case 0xfd:
-            sbc_abx();
-            break;
-        case 0xfe:
-            inc_abx();
-            break;
-        default:
-            printf("[2A03] Opcode: %02X", opcode);
-            throw std::runtime_error("[2A03] Unknown opcode!");
-    }
-
-    tick();
 }
\ No newline at end of file
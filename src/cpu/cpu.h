@@ -3,7 +3,12 @@
 #define CIEL_CPU_H
 
 
+#include <cstdio>
 #include <memory>
+#include <vector>
+
+#include "opcodes.h"
+#include "recompiled.h"
 
 enum CPU_Flags
 {
@@ -38,30 +43,105 @@ struct CPU_Registers
 };
 
 class MMU;
+class Scheduler;
 
 class CPU
 {
 private:
+    typedef void (CPU::*Instruction_Handler)();
+
+    // what an instruction does on each cycle after its opcode fetch, one step per cycle up to the nullptr
+    template <Instruction_Handler... steps> static constexpr Instruction_Handler step_sequence[] = { steps..., nullptr };
+
+    static const Instruction_Handler *const instruction_table[256];
+    static const Instruction_Handler whole_instruction_table[256];
+
+    // PRG-ROM instructions with their operand bytes, so executing them doesn't go through the bus
+    struct Decoded_Instruction
+    {
+        uint32_t prg_generation;
+        uint16_t pc;
+        uint8_t bytes[3];
+    };
+
+    std::vector<Decoded_Instruction> decode_cache;
+    const Decoded_Instruction *decoded;
+
+    // a basic block of PRG-ROM code decoded up front with its handlers looked up, it stays valid as long as the pages it
+    // was read from are mapped, so bank switches only retranslate the blocks they actually move
+    struct Translated_Instruction
+    {
+        Decoded_Instruction decoded;
+        Instruction_Handler handler;
+    };
+
+    struct Translated_Block
+    {
+        uint16_t pc;
+        uint16_t end;
+        const uint8_t *pages[2];
+        std::vector<Translated_Instruction> instructions;
+    };
+
+    std::vector<Translated_Block> block_cache;
+
+    // routines of a recompiled module by the PRG-ROM address they can be entered at, empty without one
+    std::vector<Recompiled_Routine> recompiled_routines;
+    Recompiled_Context recompiled_context;
+    uint32_t recompiled_generation;
+    uint64_t recompiled_cycles;
+
     CPU_Registers regs;
     std::shared_ptr<MMU> mmu;
 
+    // everything an instruction keeps between its cycles, resume points at the step for its next cycle
+    struct Instruction_Frame
+    {
+        const Instruction_Handler *resume;
+        uint8_t opcode;
+        uint8_t operand;
+        uint16_t effective_addr;
+        uint16_t correct_addr;
+        uint8_t addr_hi;
+        uint8_t addr_lo;
+        uint8_t pointer;
+        int8_t relative_offset;
+    };
+
+    Instruction_Frame frame;
+
+    uint16_t instruction_pc;
     uint8_t i_cycle;
-    uint8_t operand;
-    uint16_t effective_addr;
     uint64_t cycles;
 
-    bool page_boundary_crossed;
-    bool service_nmi;
+    // N and Z are only materialized in P when it is pushed or traced
+    uint8_t n_result;
+    uint8_t z_result;
+
+    uint8_t dma_byte;
+    uint8_t dma_lo;
+    uint16_t dma_elapsed;
+
+    std::FILE *trace_file;
 
     inline void tick();
-    inline void reset_ticks();
-    // inline void dump_registers() const;
+    inline void skip_steps();
+    inline void begin_instruction(const Decoded_Instruction *instruction);
+    inline void finish_instruction(Instruction_Handler handler);
+    inline void trace_instruction(uint16_t pc) const;
 
     [[nodiscard]] inline bool is_flag_set(CPU_Flags flag) const;
     inline void clear_flag(CPU_Flags flag);
     inline void set_flag(CPU_Flags flag);
 
     inline void check_nz(uint8_t value);
+    [[nodiscard]] inline uint8_t get_status() const;
+    inline void set_status(uint8_t status);
+
+    [[nodiscard]] inline const Decoded_Instruction *decode(uint16_t pc);
+    [[nodiscard]] const Translated_Block *translate(uint16_t pc);
+    [[nodiscard]] inline uint8_t read_instruction_byte() const;
+    inline uint8_t fetch_instruction_byte();
 
     [[nodiscard]] inline uint8_t read_memory(uint16_t address) const;
     inline void write_memory(uint8_t byte, uint16_t address);
@@ -71,190 +151,136 @@ private:
 
     inline void oam_dma();
 
-    inline void absolute(bool store = false);
-    inline void absolute_indexed(uint8_t index, bool store = false);
-    inline void immediate();
-    inline void implied() const;
-    inline void indexed_indirect(bool store = false);
-    inline void indirect_indexed(bool store = false);
-    inline void zero_page(bool store = false);
-    inline void zero_page_indexed(uint8_t index, bool store = false);
+    inline void implied();
+
+    // the cycle steps of the memory-operand instructions, put together per addressing mode
+    void fetch_zero_page();
+    void fetch_pointer();
+    void fetch_address_low();
+    void fetch_address_high();
+    template <uint8_t CPU_Registers::*index> void fetch_address_high_indexed();
+    template <uint8_t CPU_Registers::*index> void index_zero_page();
+    void index_pointer();
+    void read_pointer_low();
+    void read_pointer_high();
+    void read_pointer_high_indexed();
+    void fix_address();
+    void read_operand();
+    void write_operand();
+
+    template <void (CPU::*operation)()> void operate_immediate();
+    template <void (CPU::*operation)()> void operate();
+    template <void (CPU::*operation)()> void operate_unless_crossed();
+    template <void (CPU::*operation)(uint8_t &)> void modify();
+    template <uint8_t CPU_Registers::*reg> void write_register();
+
+    template <Addressing_Mode mode, Instruction_Handler... tail> static constexpr const Instruction_Handler *address_steps();
+    template <Addressing_Mode mode, void (CPU::*operation)()> static constexpr const Instruction_Handler *read_steps();
+    template <Addressing_Mode mode, void (CPU::*operation)(uint8_t &)>
+    static constexpr const Instruction_Handler *read_modify_write_steps();
+    template <Addressing_Mode mode, uint8_t CPU_Registers::*reg> static constexpr const Instruction_Handler *store_steps();
+
+    // the cycle steps of branches, jumps, interrupts and stack instructions
+    template <CPU_Flags flag, bool set> void fetch_branch_offset();
+    void add_branch_offset();
+    void fix_branch_page();
+    template <CPU_Flags flag, bool set> static constexpr const Instruction_Handler *branch_steps();
+
+    void internal_operation();
+    void skip_padding_byte();
+    void rewind_pc();
+    void increment_pc();
+    void jump();
+    void read_indirect_low();
+    void read_indirect_high();
+    template <uint16_t vector> void read_vector_low();
+    template <uint16_t vector> void read_vector_high();
 
-    inline void add_with_carry(uint8_t value);
+    void push_pch();
+    void push_pcl();
+    void push_accumulator();
+    template <uint8_t flags> void push_status();
+    void increment_stack_pointer();
+    void pull_accumulator();
+    template <bool advance> void pull_status();
+    void pull_pcl();
+    void pull_pch();
+
+    // the same instructions in one call, each bus access still sees the cycle count it would have been made at
+    template <Addressing_Mode mode> inline void address_instruction(bool store);
+    inline void index_address_instruction(uint8_t index, bool store);
+
+    template <Addressing_Mode mode, void (CPU::*operation)()> void read_instruction();
+    template <Addressing_Mode mode, void (CPU::*operation)(uint8_t &)> void read_modify_write_instruction();
+    template <Addressing_Mode mode, uint8_t CPU_Registers::*reg> void store_instruction();
+
+    inline void add_with_carry();
     inline void bit_test();
-    inline void branch(bool condition);
-    inline void compare(uint8_t reg);
+    template <uint8_t CPU_Registers::*reg> inline void compare();
     inline void decrement(uint8_t &reg);
     inline void increment(uint8_t &reg);
-    inline void load_register(uint8_t &reg);
+    template <uint8_t CPU_Registers::*reg> inline void load();
     inline void logical_and();
     inline void logical_or();
     inline void logical_shift_left(uint8_t &reg);
     inline void logical_shift_right(uint8_t &reg);
     inline void logical_xor();
-    inline void non_maskable_interrupt();
     inline void rotate_left(uint8_t &reg);
     inline void rotate_right(uint8_t &reg);
-    inline void software_interrupt();
-    inline void store_register(uint8_t reg);
+    inline void subtract_with_carry();
     inline void transfer(uint8_t source, uint8_t &target, bool txs = false);
 
-    void adc_abs();
-    void adc_abx();
-    void adc_aby();
-    void adc_imm();
-    void adc_izx();
-    void adc_izy();
-    void adc_zpa();
-    void adc_zpx();
-    void and_abs();
-    void and_abx();
-    void and_aby();
-    void and_imm();
-    void and_izx();
-    void and_izy();
-    void and_zpa();
-    void and_zpx();
     void asl();
-    void asl_abs();
-    void asl_abx();
-    void asl_zpa();
-    void asl_zpx();
-    void bcc();
-    void bcs();
-    void beq();
-    void bit_abs();
-    void bit_zpa();
-    void bmi();
-    void bne();
-    void bpl();
-    void bvc();
-    void bvs();
     void clc();
     void cld();
     void clv();
-    void cmp_abs();
-    void cmp_abx();
-    void cmp_aby();
-    void cmp_imm();
-    void cmp_izx();
-    void cmp_izy();
-    void cmp_zpa();
-    void cmp_zpx();
-    void cpx_abs();
-    void cpx_imm();
-    void cpx_zpa();
-    void cpy_abs();
-    void cpy_imm();
-    void cpy_zpa();
-    void dec_abs();
-    void dec_abx();
-    void dec_zpa();
-    void dec_zpx();
     void dex();
     void dey();
-    void eor_abs();
-    void eor_abx();
-    void eor_aby();
-    void eor_imm();
-    void eor_izx();
-    void eor_izy();
-    void eor_zpa();
-    void eor_zpx();
-    void inc_abs();
-    void inc_abx();
-    void inc_zpa();
-    void inc_zpx();
     void inx();
     void iny();
-    void jmp_abs();
-    void jmp_ind();
-    void jsr();
-    void lda_abs();
-    void lda_abx();
-    void lda_aby();
-    void lda_imm();
-    void lda_izx();
-    void lda_izy();
-    void lda_zpa();
-    void lda_zpx();
-    void ldx_abs();
-    void ldx_aby();
-    void ldx_imm();
-    void ldx_zpa();
-    void ldx_zpy();
-    void ldy_abs();
-    void ldy_abx();
-    void ldy_imm();
-    void ldy_zpa();
-    void ldy_zpx();
     void lsr();
-    void lsr_abs();
-    void lsr_abx();
-    void lsr_zpa();
-    void lsr_zpx();
     void nop_imp();
-    void ora_abs();
-    void ora_abx();
-    void ora_aby();
-    void ora_imm();
-    void ora_izx();
-    void ora_izy();
-    void ora_zpa();
-    void ora_zpx();
-    void pha();
-    void php();
-    void pla();
-    void plp();
     void rol();
-    void rol_abs();
-    void rol_abx();
-    void rol_zpa();
-    void rol_zpx();
     void ror();
-    void ror_abs();
-    void ror_abx();
-    void ror_zpa();
-    void ror_zpx();
-    void rti();
-    void rts();
-    void sbc_abs();
-    void sbc_abx();
-    void sbc_aby();
-    void sbc_imm();
-    void sbc_izx();
-    void sbc_izy();
-    void sbc_zpa();
-    void sbc_zpx();
     void sec();
     void sed();
     void sei();
-    void sta_abs();
-    void sta_abx();
-    void sta_aby();
-    void sta_izx();
-    void sta_izy();
-    void sta_zpa();
-    void sta_zpx();
-    void stx_abs();
-    void stx_zpa();
-    void stx_zpy();
-    void sty_abs();
-    void sty_zpa();
-    void sty_zpx();
     void tax();
     void tay();
     void tsx();
     void txa();
     void txs();
     void tya();
+    void unknown_opcode();
+
+    // the MMU accesses recompiled code can't make through the page tables, with the CPU's cycles brought up to date
+    static uint8_t read_recompiled_io(Recompiled_Context *context, uint16_t address, uint16_t pc);
+    static void write_recompiled_io(Recompiled_Context *context, uint8_t byte, uint16_t address, uint16_t pc);
+    static void run_recompiled_oam_dma(Recompiled_Context *context);
+
+    void run_recompiled(Scheduler &scheduler);
 public:
     explicit CPU(const std::shared_ptr<MMU> &mmu);
     ~CPU();
 
-    bool is_running;
+    [[nodiscard]] uint16_t get_instruction_pc() const;
+    [[nodiscard]] uint64_t get_cycles() const;
+    [[nodiscard]] uint64_t get_recompiled_cycles() const;
+    [[nodiscard]] uint8_t idle_loop_cycles() const;
+    uint64_t run_fused_idiom(uint64_t cycle_budget);
+    void skip_cycles(uint64_t count);
+
+    void enable_trace(const char *path);
+
+    // runs PRG-ROM code through the module's routines from now on, the module has to be built for the same PRG-ROM
+    void attach_recompiled(const Recompiled_Module *module);
 
     void run_cycle();
+    uint8_t run_instruction();
+
+    // runs recompiled code or the translated block at PC, or a single instruction where there is neither, and advances
+    // the master clock after every instruction so that the block is left as soon as an event is due
+    void run_block(Scheduler &scheduler);
 };
 
 
@@ -0,0 +1,59 @@
+#include "disassembler.h"
+
+#include "opcodes.h"
+
+#include <cstdio>
+
+void disassemble(const uint16_t pc, const uint8_t *bytes, char *text, const size_t size)
+{
+    const Opcode_Info &info = opcode_table[bytes[0]];
+    uint16_t address = 0;
+
+    if (instruction_length(info.mode) == 3)
+    {
+        address = (uint16_t)(bytes[2] << 8u) | bytes[1];
+    }
+
+    switch (info.mode)
+    {
+        case Implied:
+            std::snprintf(text, size, "%s", info.mnemonic);
+            break;
+        case Accumulator:
+            std::snprintf(text, size, "%s A", info.mnemonic);
+            break;
+        case Immediate:
+            std::snprintf(text, size, "%s #$%02X", info.mnemonic, bytes[1]);
+            break;
+        case ZeroPage:
+            std::snprintf(text, size, "%s $%02X", info.mnemonic, bytes[1]);
+            break;
+        case ZeroPageX:
+            std::snprintf(text, size, "%s $%02X,X", info.mnemonic, bytes[1]);
+            break;
+        case ZeroPageY:
+            std::snprintf(text, size, "%s $%02X,Y", info.mnemonic, bytes[1]);
+            break;
+        case Absolute:
+            std::snprintf(text, size, "%s $%04X", info.mnemonic, address);
+            break;
+        case AbsoluteX:
+            std::snprintf(text, size, "%s $%04X,X", info.mnemonic, address);
+            break;
+        case AbsoluteY:
+            std::snprintf(text, size, "%s $%04X,Y", info.mnemonic, address);
+            break;
+        case Indirect:
+            std::snprintf(text, size, "%s ($%04X)", info.mnemonic, address);
+            break;
+        case IndexedIndirect:
+            std::snprintf(text, size, "%s ($%02X,X)", info.mnemonic, bytes[1]);
+            break;
+        case IndirectIndexed:
+            std::snprintf(text, size, "%s ($%02X),Y", info.mnemonic, bytes[1]);
+            break;
+        case Relative:
+            std::snprintf(text, size, "%s $%04X", info.mnemonic, (uint16_t)(pc + 2 + (int8_t)bytes[1]));
+            break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#ifndef CIEL_DISASSEMBLER_H
+#define CIEL_DISASSEMBLER_H
+
+
+#include <cstddef>
+#include <cstdint>
+
+// writes the instruction at pc as assembly, bytes has to hold all of its instruction bytes
+void disassemble(uint16_t pc, const uint8_t *bytes, char *text, size_t size);
+
+
+#endif //CIEL_DISASSEMBLER_H
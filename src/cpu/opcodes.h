@@ -0,0 +1,338 @@
+#pragma once
+#ifndef CIEL_OPCODES_H
+#define CIEL_OPCODES_H
+
+
+#include <cstdint>
+
+enum Addressing_Mode
+{
+    Implied,
+    Accumulator,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    Indirect,
+    IndexedIndirect,
+    IndirectIndexed,
+    Relative
+};
+
+// what an instruction does with its effective address, jumps and the stack don't count
+enum Memory_Access
+{
+    NoAccess,
+    ReadAccess,
+    WriteAccess,
+    ReadModifyWriteAccess
+};
+
+struct Opcode_Info
+{
+    const char *mnemonic;
+    Addressing_Mode mode;
+    uint8_t cycles;
+    // one extra cycle when indexing crosses a page, or for branches when taken and another when the target is on a new page
+    bool page_cross_penalty;
+    Memory_Access access;
+};
+
+constexpr uint8_t instruction_length(const Addressing_Mode mode)
+{
+    switch (mode)
+    {
+        case Implied:
+        case Accumulator:
+            return 1;
+        case Absolute:
+        case AbsoluteX:
+        case AbsoluteY:
+        case Indirect:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+// official opcodes, the rest are listed as "???" with no cycles
+constexpr Opcode_Info opcode_table[256] = {
+        // 0h, ...
+        { "BRK", Implied, 7, false, NoAccess },
+        { "ORA", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ORA", ZeroPage, 3, false, ReadAccess },
+        { "ASL", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "PHP", Implied, 3, false, NoAccess },
+        { "ORA", Immediate, 2, false, NoAccess },
+        { "ASL", Accumulator, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ORA", Absolute, 4, false, ReadAccess },
+        { "ASL", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 10h, ...
+        { "BPL", Relative, 2, true, NoAccess },
+        { "ORA", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ORA", ZeroPageX, 4, false, ReadAccess },
+        { "ASL", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CLC", Implied, 2, false, NoAccess },
+        { "ORA", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ORA", AbsoluteX, 4, true, ReadAccess },
+        { "ASL", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 20h, ...
+        { "JSR", Absolute, 6, false, NoAccess },
+        { "AND", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "BIT", ZeroPage, 3, false, ReadAccess },
+        { "AND", ZeroPage, 3, false, ReadAccess },
+        { "ROL", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "PLP", Implied, 4, false, NoAccess },
+        { "AND", Immediate, 2, false, NoAccess },
+        { "ROL", Accumulator, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "BIT", Absolute, 4, false, ReadAccess },
+        { "AND", Absolute, 4, false, ReadAccess },
+        { "ROL", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 30h, ...
+        { "BMI", Relative, 2, true, NoAccess },
+        { "AND", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "AND", ZeroPageX, 4, false, ReadAccess },
+        { "ROL", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "SEC", Implied, 2, false, NoAccess },
+        { "AND", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "AND", AbsoluteX, 4, true, ReadAccess },
+        { "ROL", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 40h, ...
+        { "RTI", Implied, 6, false, NoAccess },
+        { "EOR", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "EOR", ZeroPage, 3, false, ReadAccess },
+        { "LSR", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "PHA", Implied, 3, false, NoAccess },
+        { "EOR", Immediate, 2, false, NoAccess },
+        { "LSR", Accumulator, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "JMP", Absolute, 3, false, NoAccess },
+        { "EOR", Absolute, 4, false, ReadAccess },
+        { "LSR", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 50h, ...
+        { "BVC", Relative, 2, true, NoAccess },
+        { "EOR", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "EOR", ZeroPageX, 4, false, ReadAccess },
+        { "LSR", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CLI", Implied, 2, false, NoAccess },
+        { "EOR", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "EOR", AbsoluteX, 4, true, ReadAccess },
+        { "LSR", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 60h, ...
+        { "RTS", Implied, 6, false, NoAccess },
+        { "ADC", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ADC", ZeroPage, 3, false, ReadAccess },
+        { "ROR", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "PLA", Implied, 4, false, NoAccess },
+        { "ADC", Immediate, 2, false, NoAccess },
+        { "ROR", Accumulator, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "JMP", Indirect, 5, false, NoAccess },
+        { "ADC", Absolute, 4, false, ReadAccess },
+        { "ROR", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 70h, ...
+        { "BVS", Relative, 2, true, NoAccess },
+        { "ADC", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ADC", ZeroPageX, 4, false, ReadAccess },
+        { "ROR", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "SEI", Implied, 2, false, NoAccess },
+        { "ADC", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "ADC", AbsoluteX, 4, true, ReadAccess },
+        { "ROR", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 80h, ...
+        { "???", Implied, 0, false, NoAccess },
+        { "STA", IndexedIndirect, 6, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "STY", ZeroPage, 3, false, WriteAccess },
+        { "STA", ZeroPage, 3, false, WriteAccess },
+        { "STX", ZeroPage, 3, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "DEY", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "TXA", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "STY", Absolute, 4, false, WriteAccess },
+        { "STA", Absolute, 4, false, WriteAccess },
+        { "STX", Absolute, 4, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // 90h, ...
+        { "BCC", Relative, 2, true, NoAccess },
+        { "STA", IndirectIndexed, 6, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "STY", ZeroPageX, 4, false, WriteAccess },
+        { "STA", ZeroPageX, 4, false, WriteAccess },
+        { "STX", ZeroPageY, 4, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "TYA", Implied, 2, false, NoAccess },
+        { "STA", AbsoluteY, 5, false, WriteAccess },
+        { "TXS", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "STA", AbsoluteX, 5, false, WriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // A0h, ...
+        { "LDY", Immediate, 2, false, NoAccess },
+        { "LDA", IndexedIndirect, 6, false, ReadAccess },
+        { "LDX", Immediate, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "LDY", ZeroPage, 3, false, ReadAccess },
+        { "LDA", ZeroPage, 3, false, ReadAccess },
+        { "LDX", ZeroPage, 3, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "TAY", Implied, 2, false, NoAccess },
+        { "LDA", Immediate, 2, false, NoAccess },
+        { "TAX", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "LDY", Absolute, 4, false, ReadAccess },
+        { "LDA", Absolute, 4, false, ReadAccess },
+        { "LDX", Absolute, 4, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // B0h, ...
+        { "BCS", Relative, 2, true, NoAccess },
+        { "LDA", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "LDY", ZeroPageX, 4, false, ReadAccess },
+        { "LDA", ZeroPageX, 4, false, ReadAccess },
+        { "LDX", ZeroPageY, 4, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CLV", Implied, 2, false, NoAccess },
+        { "LDA", AbsoluteY, 4, true, ReadAccess },
+        { "TSX", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "LDY", AbsoluteX, 4, true, ReadAccess },
+        { "LDA", AbsoluteX, 4, true, ReadAccess },
+        { "LDX", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // C0h, ...
+        { "CPY", Immediate, 2, false, NoAccess },
+        { "CMP", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CPY", ZeroPage, 3, false, ReadAccess },
+        { "CMP", ZeroPage, 3, false, ReadAccess },
+        { "DEC", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "INY", Implied, 2, false, NoAccess },
+        { "CMP", Immediate, 2, false, NoAccess },
+        { "DEX", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CPY", Absolute, 4, false, ReadAccess },
+        { "CMP", Absolute, 4, false, ReadAccess },
+        { "DEC", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // D0h, ...
+        { "BNE", Relative, 2, true, NoAccess },
+        { "CMP", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CMP", ZeroPageX, 4, false, ReadAccess },
+        { "DEC", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CLD", Implied, 2, false, NoAccess },
+        { "CMP", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CMP", AbsoluteX, 4, true, ReadAccess },
+        { "DEC", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // E0h, ...
+        { "CPX", Immediate, 2, false, NoAccess },
+        { "SBC", IndexedIndirect, 6, false, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CPX", ZeroPage, 3, false, ReadAccess },
+        { "SBC", ZeroPage, 3, false, ReadAccess },
+        { "INC", ZeroPage, 5, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "INX", Implied, 2, false, NoAccess },
+        { "SBC", Immediate, 2, false, NoAccess },
+        { "NOP", Implied, 2, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "CPX", Absolute, 4, false, ReadAccess },
+        { "SBC", Absolute, 4, false, ReadAccess },
+        { "INC", Absolute, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        // F0h, ...
+        { "BEQ", Relative, 2, true, NoAccess },
+        { "SBC", IndirectIndexed, 5, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "SBC", ZeroPageX, 4, false, ReadAccess },
+        { "INC", ZeroPageX, 6, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "SED", Implied, 2, false, NoAccess },
+        { "SBC", AbsoluteY, 4, true, ReadAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "???", Implied, 0, false, NoAccess },
+        { "SBC", AbsoluteX, 4, true, ReadAccess },
+        { "INC", AbsoluteX, 7, false, ReadModifyWriteAccess },
+        { "???", Implied, 0, false, NoAccess }
+};
+
+
+#endif //CIEL_OPCODES_H
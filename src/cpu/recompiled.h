@@ -0,0 +1,239 @@
+#pragma once
+#ifndef CIEL_RECOMPILED_H
+#define CIEL_RECOMPILED_H
+
+
+#include <cstdint>
+
+// the interface between the instruction-stepped core and NROM code recompiled to C++ by Code_Tracer::write_module, the
+// generated source includes this header and is built into a module that is loaded at runtime
+
+// bumped whenever anything below changes, modules built against another version are refused
+constexpr uint32_t recompiled_abi_version = 1;
+
+constexpr uint64_t recompiled_hash_seed = 0xcbf29ce484222325u;
+constexpr uint64_t recompiled_clock_divider = 12;
+
+constexpr char recompiled_module_symbol[] = "ciel_recompiled_module";
+
+// a copy of the 2A03 registers while recompiled code runs, with N and Z kept as results like in CPU
+struct Recompiled_Context
+{
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+    uint8_t n_result;
+    uint8_t z_result;
+    uint64_t cycles;
+
+    // the MMU's page tables, accesses to pages without host memory go through the handlers with the instruction's PC
+    const uint8_t *const *read_pages;
+    uint8_t *const *write_pages;
+    uint8_t (*read_io)(Recompiled_Context *context, uint16_t address, uint16_t pc);
+    void (*write_io)(Recompiled_Context *context, uint8_t byte, uint16_t address, uint16_t pc);
+    void (*run_oam_dma)(Recompiled_Context *context);
+    void *cpu;
+
+    // advanced after every instruction, the emulator takes over when an event is due or an interrupt or DMA is pending
+    uint64_t *master_clock;
+    const uint64_t *next_deadline;
+    const bool *nmi_pending;
+    const bool *oam_dma;
+};
+
+// runs from pc, which has to be an instruction of the routine, and returns where the emulator has to carry on
+typedef uint16_t (*Recompiled_Routine)(Recompiled_Context *context, uint16_t pc);
+
+struct Recompiled_Entry
+{
+    uint16_t pc;
+    Recompiled_Routine routine;
+};
+
+struct Recompiled_Module
+{
+    uint32_t abi_version;
+    // of the 32 KiB the CPU sees from 8000h on
+    uint64_t prg_checksum;
+    uint32_t entry_count;
+    const Recompiled_Entry *entries;
+};
+
+// the one symbol a module exports, under recompiled_module_symbol
+extern "C" const Recompiled_Module *ciel_recompiled_module();
+
+typedef const Recompiled_Module *(*Recompiled_Module_Getter)();
+
+// FNV-1a
+inline uint64_t recompiled_hash(const uint64_t hash, const uint8_t byte)
+{
+    return (hash ^ byte) * 0x100000001b3u;
+}
+
+// the rest is only used by generated code, it does what the CPU's whole-instruction handlers do
+
+inline uint8_t recompiled_read(Recompiled_Context *context, const uint16_t address, const uint16_t pc)
+{
+    const uint8_t *page = context->read_pages[address >> 8u];
+
+    if (page != nullptr)
+    {
+        return page[address & 0xffu];
+    }
+
+    return context->read_io(context, address, pc);
+}
+
+inline void recompiled_write(Recompiled_Context *context, const uint8_t byte, const uint16_t address, const uint16_t pc)
+{
+    uint8_t *page = context->write_pages[address >> 8u];
+
+    if (page != nullptr)
+    {
+        page[address & 0xffu] = byte;
+        return;
+    }
+
+    context->write_io(context, byte, address, pc);
+}
+
+// the address without the carry into the high byte is read first, which costs a cycle on page crossings and always for
+// stores and read-modify-writes
+inline uint16_t recompiled_index(Recompiled_Context *context, const uint16_t base, const uint8_t index,
+                                 const bool store, const uint16_t pc)
+{
+    const uint16_t address = base + index;
+
+    if (store || ((base ^ address) & 0xff00u) != 0)
+    {
+        (void)recompiled_read(context, (base & 0xff00u) | (uint8_t)address, pc);
+        ++context->cycles;
+    }
+
+    return address;
+}
+
+// zero page is internal RAM, so pointers in it are read without the handlers
+inline uint16_t recompiled_pointer(const Recompiled_Context *context, const uint8_t pointer)
+{
+    const uint8_t *zero_page = context->read_pages[0];
+
+    return (uint16_t)(zero_page[(uint8_t)(pointer + 1u)] << 8u) | zero_page[pointer];
+}
+
+inline void recompiled_push(Recompiled_Context *context, const uint8_t byte)
+{
+    context->write_pages[1][context->sp--] = byte;
+}
+
+inline uint8_t recompiled_pull(const Recompiled_Context *context)
+{
+    return context->read_pages[1][context->sp];
+}
+
+inline void recompiled_nz(Recompiled_Context *context, const uint8_t value)
+{
+    context->n_result = value;
+    context->z_result = value;
+}
+
+inline void recompiled_load(Recompiled_Context *context, uint8_t &reg, const uint8_t value)
+{
+    reg = value;
+
+    recompiled_nz(context, value);
+}
+
+inline uint8_t recompiled_status(const Recompiled_Context *context)
+{
+    return (context->p & 0x7du) | ((context->z_result == 0) ? 0x2u : 0) | (context->n_result & 0x80u);
+}
+
+inline void recompiled_set_status(Recompiled_Context *context, const uint8_t status)
+{
+    context->p = status;
+    context->n_result = status & 0x80u;
+    context->z_result = ~status & 0x2u;
+}
+
+// PLP and RTI leave the B and unused bits alone
+inline void recompiled_pull_status(Recompiled_Context *context)
+{
+    ++context->sp;
+
+    recompiled_set_status(context, (context->p & 0x30u) | (recompiled_pull(context) & 0xcfu));
+}
+
+inline void recompiled_adc(Recompiled_Context *context, const uint8_t value)
+{
+    const uint16_t result = context->a + value + (context->p & 0x1u);
+    const bool overflow = ((context->a & 0x80u) == (value & 0x80u)) && ((context->a & 0x80u) != (result & 0x80u));
+
+    context->p = (context->p & 0xbeu) | (result > 255) | (overflow ? 0x40u : 0);
+    context->a = (uint8_t)result;
+
+    recompiled_nz(context, context->a);
+}
+
+inline void recompiled_compare(Recompiled_Context *context, const uint8_t reg, const uint8_t value)
+{
+    context->p = (context->p & 0xfeu) | (reg >= value);
+
+    recompiled_nz(context, reg - value);
+}
+
+inline void recompiled_bit(Recompiled_Context *context, const uint8_t value)
+{
+    context->z_result = context->a & value;
+    context->n_result = value;
+    context->p = (context->p & 0xbfu) | (value & 0x40u);
+}
+
+inline void recompiled_asl(Recompiled_Context *context, uint8_t &value)
+{
+    context->p = (context->p & 0xfeu) | (value >> 7u);
+    value <<= 1u;
+
+    recompiled_nz(context, value);
+}
+
+inline void recompiled_lsr(Recompiled_Context *context, uint8_t &value)
+{
+    context->p = (context->p & 0xfeu) | (value & 0x1u);
+    value >>= 1u;
+
+    recompiled_nz(context, value);
+}
+
+inline void recompiled_rol(Recompiled_Context *context, uint8_t &value)
+{
+    const uint8_t carry = context->p & 0x1u;
+
+    context->p = (context->p & 0xfeu) | (value >> 7u);
+    value = (uint8_t)(value << 1u) | carry;
+
+    recompiled_nz(context, value);
+}
+
+inline void recompiled_ror(Recompiled_Context *context, uint8_t &value)
+{
+    const uint8_t carry = context->p & 0x1u;
+
+    context->p = (context->p & 0xfeu) | (value & 0x1u);
+    value = (value >> 1u) | (uint8_t)(carry << 7u);
+
+    recompiled_nz(context, value);
+}
+
+// moves the master clock past an instruction like CPU::run_block does, and tells whether the emulator has to take over
+inline bool recompiled_retire(Recompiled_Context *context, const uint64_t start_cycles)
+{
+    *context->master_clock += recompiled_clock_divider * (context->cycles - start_cycles);
+
+    return *context->master_clock >= *context->next_deadline || *context->nmi_pending || *context->oam_dma;
+}
+
+
+#endif //CIEL_RECOMPILED_H
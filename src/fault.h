@@ -0,0 +1,29 @@
+#pragma once
+#ifndef CIEL_FAULT_H
+#define CIEL_FAULT_H
+
+
+#include <cstdint>
+
+enum Fault_Code
+{
+    NoFault,
+    UnknownOpcode,
+    UnhandledIORead,
+    InvalidRead,
+    UnhandledIOWrite,
+    InvalidWrite,
+    InvalidPPURegister
+};
+
+struct Fault
+{
+    Fault_Code code;
+    uint16_t address;
+    uint8_t byte;
+    uint16_t pc;
+    uint64_t cycle;
+};
+
+
+#endif //CIEL_FAULT_H
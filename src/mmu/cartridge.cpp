@@ -19,6 +19,11 @@ cart_info()
 Cartridge::~Cartridge()
 = default;
 
+const Cartridge_Information &Cartridge::get_info() const
+{
+    return cart_info;
+}
+
 void Cartridge::load_file(const char *path)
 {
     printf("[Cartridge] Loading file \"%s\"...\n", path);
@@ -55,6 +60,15 @@ void Cartridge::parse_rom()
     cart_info.chr_banks = cart_data[5];
     cart_info.prg_banks = cart_data[4];
     cart_info.mapper_number = (cart_data[7] & 0xf0u) | (cart_data[6] & 0xf0u) >> 4u;
+
+    if ((cart_data[6] & 0x8u) != 0)
+    {
+        cart_info.mirroring = FourScreen;
+    }
+    else
+    {
+        cart_info.mirroring = ((cart_data[6] & 0x1u) != 0) ? VerticalMirroring : HorizontalMirroring;
+    }
 }
 
 void Cartridge::print_rom_info() const
@@ -70,7 +84,7 @@ void Cartridge::init_mapper()
     switch (cart_info.mapper_number)
     {
         case 0:
-            mapper = std::make_unique<NROM>(cart_data, cart_info.chr_banks, cart_info.prg_banks);
+            mapper = std::make_unique<NROM>(cart_data, cart_info.chr_banks, cart_info.prg_banks, cart_info.mirroring);
             break;
         case 7:
             mapper = std::make_unique<AxROM>(cart_data);
@@ -7,15 +7,16 @@
 #include <memory>
 #include <vector>
 
+#include "mappers/mapper_interface/mapper.h"
+
 struct Cartridge_Information
 {
     uint8_t chr_banks;
     uint8_t prg_banks;
     uint16_t mapper_number;
+    Mirroring mirroring;
 };
 
-class Mapper;
-
 class Cartridge
 {
 private:
@@ -30,6 +31,8 @@ public:
     explicit Cartridge(const char *cartridge_path);
     ~Cartridge();
 
+    [[nodiscard]] const Cartridge_Information &get_info() const;
+
     std::unique_ptr<Mapper> mapper;
 };
 
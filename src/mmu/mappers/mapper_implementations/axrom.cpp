@@ -16,22 +16,27 @@ uint8_t AxROM::read_byte(const uint16_t address) const
     return cart_data[0x10u + (address - 0x8000u) + (0x8000u * (bank_select & 0x7u))];
 }
 
-uint8_t AxROM::read_chr(const uint16_t address) const
+const uint8_t *AxROM::get_prg_page(const uint16_t address) const
 {
-    return chr_ram[address];
+    return &cart_data[0x10u + (address - 0x8000u) + (0x8000u * (bank_select & 0x7u))];
 }
 
-uint16_t AxROM::get_nt_addr(const uint16_t address) const
+const uint8_t *AxROM::get_chr_page(const uint16_t address) const
 {
-    return (address % 0x400) + (0x400 * ((bank_select & 0x10u) != 0));
+    return &chr_ram[address];
 }
 
-void AxROM::write_byte(const uint8_t byte, const uint16_t address)
+uint8_t *AxROM::get_chr_ram_page(const uint16_t address)
 {
-    bank_select = byte;
+    return &chr_ram[address];
 }
 
-void AxROM::write_chr(const uint8_t byte, const uint16_t address)
+Mirroring AxROM::get_mirroring() const
 {
-    chr_ram[address] = byte;
+    return ((bank_select & 0x10u) != 0) ? SingleScreenHigh : SingleScreenLow;
+}
+
+void AxROM::write_byte(const uint8_t byte, const uint16_t address)
+{
+    bank_select = byte;
 }
\ No newline at end of file
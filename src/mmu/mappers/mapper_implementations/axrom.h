@@ -18,10 +18,11 @@ public:
     ~AxROM();
 
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
-    [[nodiscard]] uint8_t read_chr(uint16_t address) const override;
-    [[nodiscard]] uint16_t get_nt_addr(uint16_t address) const override;
+    [[nodiscard]] const uint8_t *get_prg_page(uint16_t address) const override;
+    [[nodiscard]] const uint8_t *get_chr_page(uint16_t address) const override;
+    [[nodiscard]] uint8_t *get_chr_ram_page(uint16_t address) override;
+    [[nodiscard]] Mirroring get_mirroring() const override;
     void write_byte(uint8_t byte, uint16_t address) override;
-    void write_chr(uint8_t byte, uint16_t address) override;
 };
 
 
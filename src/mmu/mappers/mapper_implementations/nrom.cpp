@@ -1,7 +1,7 @@
 #include "nrom.h"
 
-NROM::NROM(const std::vector<uint8_t> &cart_data, const uint8_t chr_banks, const uint8_t prg_banks) :
-chr_banks(chr_banks), prg_banks(prg_banks)
+NROM::NROM(const std::vector<uint8_t> &cart_data, const uint8_t chr_banks, const uint8_t prg_banks, const Mirroring mirroring) :
+chr_banks(chr_banks), prg_banks(prg_banks), mirroring(mirroring)
 {
     this->cart_data = cart_data;
 
@@ -24,35 +24,47 @@ uint8_t NROM::read_byte(const uint16_t address) const
     return cart_data[0x10u + (address - 0x8000)];
 }
 
-uint8_t NROM::read_chr(const uint16_t address) const
+const uint8_t *NROM::get_prg_page(const uint16_t address) const
+{
+    if (prg_banks == 1)
+    {
+        return &cart_data[0x10u + (address % 0x4000u)];
+    }
+
+    return &cart_data[0x10u + (address - 0x8000)];
+}
+
+const uint8_t *NROM::get_chr_page(const uint16_t address) const
 {
     if (chr_banks == 0)
     {
-        return chr_ram[address];
+        return &chr_ram[address];
     }
 
     if (prg_banks == 1)
     {
-        return cart_data[0x4010u + address];
+        return &cart_data[0x4010u + address];
     }
 
-    return cart_data[0x8010u + address];
+    return &cart_data[0x8010u + address];
 }
 
-uint16_t NROM::get_nt_addr(const uint16_t address) const
+uint8_t *NROM::get_chr_ram_page(const uint16_t address)
 {
-    return address - 0x2000u;
+    if (chr_banks == 0)
+    {
+        return &chr_ram[address];
+    }
+
+    return nullptr;
 }
 
-void NROM::write_byte(const uint8_t byte, const uint16_t address)
+Mirroring NROM::get_mirroring() const
 {
-
+    return mirroring;
 }
 
-void NROM::write_chr(uint8_t byte, uint16_t address)
+void NROM::write_byte(const uint8_t byte, const uint16_t address)
 {
-    if (chr_banks == 0)
-    {
-        chr_ram[address] = byte;
-    }
+
 }
\ No newline at end of file
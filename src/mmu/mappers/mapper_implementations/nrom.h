@@ -14,15 +14,17 @@ private:
     std::vector<uint8_t> chr_ram;
     uint8_t chr_banks;
     uint8_t prg_banks;
+    Mirroring mirroring;
 public:
-    NROM(const std::vector<uint8_t> &cart_data, uint8_t chr_banks, uint8_t prg_banks);
+    NROM(const std::vector<uint8_t> &cart_data, uint8_t chr_banks, uint8_t prg_banks, Mirroring mirroring);
     ~NROM();
 
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
-    [[nodiscard]] uint8_t read_chr(uint16_t address) const override;
-    [[nodiscard]] uint16_t get_nt_addr(uint16_t address) const override;
+    [[nodiscard]] const uint8_t *get_prg_page(uint16_t address) const override;
+    [[nodiscard]] const uint8_t *get_chr_page(uint16_t address) const override;
+    [[nodiscard]] uint8_t *get_chr_ram_page(uint16_t address) override;
+    [[nodiscard]] Mirroring get_mirroring() const override;
     void write_byte(uint8_t byte, uint16_t address) override;
-    void write_chr(uint8_t byte, uint16_t address) override;
 };
 
 
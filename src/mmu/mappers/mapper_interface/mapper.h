@@ -5,15 +5,25 @@
 
 #include <cinttypes>
 
+enum Mirroring
+{
+    HorizontalMirroring,
+    VerticalMirroring,
+    SingleScreenLow,
+    SingleScreenHigh,
+    FourScreen
+};
+
 class Mapper
 {
 private:
 public:
     [[nodiscard]] virtual uint8_t read_byte(uint16_t address) const = 0;
-    [[nodiscard]] virtual uint8_t read_chr(uint16_t address) const = 0;
-    [[nodiscard]] virtual uint16_t get_nt_addr(uint16_t address) const = 0;
+    [[nodiscard]] virtual const uint8_t *get_prg_page(uint16_t address) const = 0;
+    [[nodiscard]] virtual const uint8_t *get_chr_page(uint16_t address) const = 0;
+    [[nodiscard]] virtual uint8_t *get_chr_ram_page(uint16_t address) = 0;
+    [[nodiscard]] virtual Mirroring get_mirroring() const = 0;
     virtual void write_byte(uint8_t byte, uint16_t address) = 0;
-    virtual void write_chr(uint8_t byte, uint16_t address) = 0;
 };
 
 
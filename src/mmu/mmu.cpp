@@ -5,14 +5,25 @@
 #include "..//ppu/ppu.h"
 #include "..//nes.h"
 
+#include <cstdio>
+
 MMU::MMU(const std::shared_ptr<PPU> &ppu, NES *nes, const char *cartridge_path) :
-nmi_pending(false), vblank(false), oam_dma(false), oam_hi(0)
+read_pages(), write_pages(), chr_pages(), chr_write_pages(), mirroring(HorizontalMirroring), ppu_mapped(false), oam_hi(0), prg_generation(0), nmi_pending(false), oam_dma(false), vblank(false)
 {
     this->ppu = ppu;
     this->nes = nes;
     cart = std::make_unique<Cartridge>(cartridge_path);
 
     ram.resize(0x800);
+
+    // internal RAM is mirrored four times
+    for (uint16_t page = 0; page < 0x20; page++)
+    {
+        read_pages[page] = &ram[(page % 8u) * 0x100u];
+        write_pages[page] = &ram[(page % 8u) * 0x100u];
+    }
+
+    map_prg();
 }
 
 MMU::~MMU()
@@ -21,21 +32,82 @@ MMU::~MMU()
 void MMU::set_ppu(const std::shared_ptr<PPU> &ppu_)
 {
     this->ppu = ppu_;
+    ppu_mapped = false;
+
+    map_ppu();
+}
+
+void MMU::raise_fault(const Fault_Code code, const uint16_t address, const uint8_t byte)
+{
+    nes->raise_fault(code, address, byte);
 }
 
-void MMU::update_framebuffer(const uint8_t *framebuffer)
+void MMU::update_framebuffer(const uint16_t *framebuffer)
 {
     nes->update_framebuffer(framebuffer);
 }
 
-uint8_t MMU::read_byte(const uint16_t address)
+const uint8_t *MMU::get_ram() const
 {
-    if (address < 0x2000)
+    return ram.data();
+}
+
+void MMU::map_prg()
+{
+    bool changed = false;
+
+    for (uint16_t page = 0x80; page < 0x100; page++)
     {
-        return ram[address % 0x800u];
+        const uint8_t *prg_page = cart->mapper->get_prg_page(page << 8u);
+
+        changed |= read_pages[page] != prg_page;
+        read_pages[page] = prg_page;
     }
-    else if (address >= 0x2000 && address < 0x4000)
+
+    // writes to boards without PRG banking, like NROM, keep decoded and recompiled code valid
+    if (changed)
+    {
+        ++prg_generation;
+    }
+}
+
+void MMU::map_ppu()
+{
+    bool changed = !ppu_mapped || cart->mapper->get_mirroring() != mirroring;
+
+    for (uint8_t page = 0; page < 8; page++)
     {
+        const uint8_t *chr_page = cart->mapper->get_chr_page(page << 10u);
+        uint8_t *chr_write_page = cart->mapper->get_chr_ram_page(page << 10u);
+
+        changed |= chr_pages[page] != chr_page || chr_write_pages[page] != chr_write_page;
+        chr_pages[page] = chr_page;
+        chr_write_pages[page] = chr_write_page;
+    }
+
+    if (!changed)
+    {
+        return;
+    }
+
+    for (uint8_t page = 0; page < 8; page++)
+    {
+        ppu->map_chr(page, chr_pages[page], chr_write_pages[page]);
+    }
+
+    mirroring = cart->mapper->get_mirroring();
+    ppu_mapped = true;
+
+    ppu->map_nametables(mirroring);
+    ppu->invalidate_chr_rows();
+}
+
+uint8_t MMU::read_io(const uint16_t address)
+{
+    if (address >= 0x2000 && address < 0x4000)
+    {
+        nes->catch_up_ppu();
+
         return ppu->read_register(address % 8);
     }
     else if (address >= 0x4000 && address < 0x4018)
@@ -115,8 +187,8 @@ uint8_t MMU::read_byte(const uint16_t address)
                 // printf("[MMU] Read from Frame Counter\n");
                 return 0x0;
             default:
-                printf("[MMU] Address: %04X", address);
-                throw std::runtime_error("[MMU] Unhandled IO read!");
+                nes->raise_fault(UnhandledIORead, address);
+                return 0;
         }
     }
     else if (address >= 0x4020 && address < 0x8000)
@@ -128,30 +200,19 @@ uint8_t MMU::read_byte(const uint16_t address)
         return cart->mapper->read_byte(address);
     }
 
-    printf("[MMU] Address: %04Xh", address);
-    throw std::runtime_error("[MMU] Invalid byte read!");
-}
-
-uint8_t MMU::read_chr(const uint16_t address) const
-{
-    return cart->mapper->read_chr(address);
-}
-
-uint16_t MMU::get_nt_addr(const uint16_t address) const
-{
-    return cart->mapper->get_nt_addr(address);
+    nes->raise_fault(InvalidRead, address);
+    return 0;
 }
 
-void MMU::write_byte(const uint8_t byte, const uint16_t address)
+void MMU::write_io(const uint8_t byte, const uint16_t address)
 {
-    if (address < 0x2000)
-    {
-        ram[address % 0x800u] = byte;
-        return;
-    }
-    else if (address >= 0x2000 && address < 0x4000)
+    if (address >= 0x2000 && address < 0x4000)
     {
+        nes->catch_up_ppu();
         ppu->write_register(byte, address % 8);
+
+        // a PPUCTRL write during vblank can raise an NMI on the next dot
+        nes->schedule_ppu_sync();
         return;
     }
     else if (address >= 0x4000 && address < 0x4018)
@@ -230,13 +291,14 @@ void MMU::write_byte(const uint8_t byte, const uint16_t address)
             case 0x4016:
                 // printf("[MMU] Joypad #1 = %02X\n", byte);
                 nes->strobe = byte;
+                nes->schedule_event(JoypadEvent);
                 break;
             case 0x4017:
                 // printf("[MMU] Joypad #2 = %02X\n", byte);
                 break;
             default:
-                printf("[MMU] Address: %04X", address);
-                throw std::runtime_error("[MMU] Unhandled IO write!");
+                nes->raise_fault(UnhandledIOWrite, address, byte);
+                break;
         }
 
         return;
@@ -248,15 +310,14 @@ void MMU::write_byte(const uint8_t byte, const uint16_t address)
     }
     else if (address >= 0x8000)
     {
+        // bank switches change what the PPU fetches
+        nes->catch_up_ppu();
         cart->mapper->write_byte(byte, address);
+
+        map_prg();
+        map_ppu();
         return;
     }
 
-    printf("[MMU] Address: %04Xh, byte: %02Xh", address, byte);
-    throw std::runtime_error("[MMU] Invalid byte store!");
-}
-
-void MMU::write_chr(const uint8_t byte, const uint16_t address)
-{
-    cart->mapper->write_chr(byte, address);
+    nes->raise_fault(InvalidWrite, address, byte);
 }
\ No newline at end of file
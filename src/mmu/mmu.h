@@ -3,9 +3,13 @@
 #define CIEL_MMU_H
 
 
+#include <array>
 #include <memory>
 #include <vector>
 
+#include "..//fault.h"
+#include "mappers/mapper_interface/mapper.h"
+
 class Cartridge;
 class NES;
 class PPU;
@@ -17,26 +21,95 @@ private:
     std::unique_ptr<Cartridge> cart;
     std::vector<uint8_t> ram;
     NES *nes;
+
+    // host pointers to every 256-byte page of the CPU address space, nullptr if accesses need a handler
+    std::array<const uint8_t *, 0x100> read_pages;
+    std::array<uint8_t *, 0x100> write_pages;
+
+    // what the PPU was last handed, so that mapper writes that switch nothing leave its caches alone
+    std::array<const uint8_t *, 8> chr_pages;
+    std::array<uint8_t *, 8> chr_write_pages;
+    Mirroring mirroring;
+    bool ppu_mapped;
+
+    void map_prg();
+    void map_ppu();
+
+    [[nodiscard]] uint8_t read_io(uint16_t address);
+    void write_io(uint8_t byte, uint16_t address);
 public:
     MMU(const std::shared_ptr<PPU> &ppu, NES *nes, const char *cartridge_path);
     ~MMU();
 
     uint8_t oam_hi;
 
+    // bumped whenever the PRG mapping changes, so decoded ROM code can tell it is stale
+    uint32_t prg_generation;
+
     bool nmi_pending;
     bool oam_dma;
     bool vblank;
 
     void set_ppu(const std::shared_ptr<PPU> &ppu_);
 
-    void update_framebuffer(const uint8_t *framebuffer);
+    void raise_fault(Fault_Code code, uint16_t address, uint8_t byte = 0);
+    void update_framebuffer(const uint16_t *framebuffer);
 
     [[nodiscard]] uint8_t read_byte(uint16_t address);
-    [[nodiscard]] uint8_t read_chr(uint16_t address) const;
-    [[nodiscard]] uint16_t get_nt_addr(uint16_t address) const;
     void write_byte(uint8_t byte, uint16_t address);
-    void write_chr(uint8_t byte, uint16_t address);
+
+    // the host memory the page holding address is read from, nullptr if reads from it need a handler
+    [[nodiscard]] const uint8_t *get_read_page(uint16_t address) const;
+
+    // the page tables themselves, for recompiled code to access memory the way read_byte and write_byte do
+    [[nodiscard]] const uint8_t *const *get_read_pages() const;
+    [[nodiscard]] uint8_t *const *get_write_pages() const;
+
+    // the 2 KB of internal RAM
+    [[nodiscard]] const uint8_t *get_ram() const;
 };
 
+// the page table lookups are defined here so that the CPU core can inline them into every bus access
+
+inline uint8_t MMU::read_byte(const uint16_t address)
+{
+    const uint8_t *page = read_pages[address >> 8u];
+
+    if (page != nullptr)
+    {
+        return page[address & 0xffu];
+    }
+
+    return read_io(address);
+}
+
+inline void MMU::write_byte(const uint8_t byte, const uint16_t address)
+{
+    uint8_t *page = write_pages[address >> 8u];
+
+    if (page != nullptr)
+    {
+        page[address & 0xffu] = byte;
+        return;
+    }
+
+    write_io(byte, address);
+}
+
+inline const uint8_t *MMU::get_read_page(const uint16_t address) const
+{
+    return read_pages[address >> 8u];
+}
+
+inline const uint8_t *const *MMU::get_read_pages() const
+{
+    return read_pages.data();
+}
+
+inline uint8_t *const *MMU::get_write_pages() const
+{
+    return write_pages.data();
+}
+
 
 #endif //CIEL_MMU_H
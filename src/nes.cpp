@@ -4,8 +4,28 @@
 #include "mmu/mmu.h"
 #include "ppu/ppu.h"
 
-NES::NES(const char *cartridge_path) :
-renderer(nullptr), window(nullptr), texture(nullptr), event(), joy(0), strobe(0)
+#include <cinttypes>
+#include <stdexcept>
+
+// the SDL texture format with the same memory layout
+static uint32_t get_sdl_format(const Pixel_Format format)
+{
+    switch (format)
+    {
+        case XRGB8888:
+            return SDL_PIXELFORMAT_RGB888;
+        case RGB565:
+            return SDL_PIXELFORMAT_RGB565;
+        default:
+            return SDL_PIXELFORMAT_RGB24;
+    }
+}
+
+NES::NES(const char *cartridge_path, const Stepping_Mode stepping_mode) :
+stepping_mode(stepping_mode), scheduler(), cycle_base(0), ppu_dots(0), fault(), halted(false), frames(0), frame_target(0),
+block_translation(false), recompiled_module(nullptr), idle_skipping(false), idiom_fusing(false), frame_start_cycles(0), frame_idle_cycles(0), total_idle_cycles(0),
+total_idle_time_saved(0), frame_start(), fast_forward_time(), palette(), pixel_format(XRGB8888), pixels(256 * 240 * Palette::bytes_per_pixel(XRGB8888)), renderer(nullptr), window(nullptr), texture(nullptr), event(), joy(0), strobe(0),
+idle_cycles_skipped(0), idle_time_saved(0)
 {
     printf("------------------------------------------------\n");
     printf("----------- Ciel NES Emulator v0.1.0 -----------\n");
@@ -17,11 +37,31 @@ renderer(nullptr), window(nullptr), texture(nullptr), event(), joy(0), strobe(0)
 
     mmu->set_ppu(ppu);
 
+    cycle_base = cpu->get_cycles();
+
+    if (stepping_mode == InstructionStepped)
+    {
+        printf("[Ciel] Instruction-stepped CPU core enabled\n");
+
+        schedule_ppu_sync();
+    }
+
     init_sdl();
 }
 
 NES::~NES()
-= default;
+{
+    if (idle_skipping && frames != 0)
+    {
+        printf("[Ciel] Idle-loop skipping: %.1f CPU cycles and %.1f us of host time saved per frame\n",
+               (double)total_idle_cycles / frames, total_idle_time_saved / frames);
+    }
+
+    if (recompiled_module != nullptr)
+    {
+        SDL_UnloadObject(recompiled_module);
+    }
+}
 
 void NES::init_sdl()
 {
@@ -33,14 +73,58 @@ void NES::init_sdl()
     SDL_SetWindowResizable(window, SDL_FALSE);
     SDL_SetWindowTitle(window, "Ciel NES emulator v0.1.0");
 
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, 256, 240);
+    texture = SDL_CreateTexture(renderer, get_sdl_format(pixel_format), SDL_TEXTUREACCESS_STREAMING, 256, 240);
 }
 
-void NES::update_framebuffer(const uint8_t *framebuffer)
+void NES::update_framebuffer(const uint16_t *framebuffer)
 {
-    SDL_UpdateTexture(texture, nullptr, framebuffer, 256 * sizeof(uint8_t) * 3);
-    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-    SDL_RenderPresent(renderer);
+    if (idle_skipping)
+    {
+        using namespace std::chrono;
+
+        // what the skipped cycles would have cost at this frame's stepped rate, minus the fast-forwarding itself
+        const double stepped_time = duration<double, std::micro>(steady_clock::now() - frame_start - fast_forward_time).count();
+        const uint64_t stepped_cycles = cpu->get_cycles() - frame_start_cycles - frame_idle_cycles;
+
+        idle_cycles_skipped = frame_idle_cycles;
+        idle_time_saved = 0;
+
+        if (stepped_cycles != 0)
+        {
+            idle_time_saved = stepped_time * idle_cycles_skipped / stepped_cycles -
+                              duration<double, std::micro>(fast_forward_time).count();
+        }
+
+        total_idle_cycles += idle_cycles_skipped;
+        total_idle_time_saved += idle_time_saved;
+    }
+
+    // games that don't read the joypad never poll for events, and the key events are left to strobe_joypad
+    SDL_PumpEvents();
+
+    if (++frames == frame_target || SDL_HasEvent(SDL_QUIT))
+    {
+        schedule_event(HaltEvent);
+    }
+
+    // skipped frames come without pixels
+    if (framebuffer != nullptr)
+    {
+        palette.convert(framebuffer, pixel_format, pixels.data());
+
+        SDL_UpdateTexture(texture, nullptr, pixels.data(), 256 * Palette::bytes_per_pixel(pixel_format));
+        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+        SDL_RenderPresent(renderer);
+    }
+
+    if (idle_skipping)
+    {
+        // the next frame starts after presenting so that waiting for vsync isn't counted
+        frame_start = std::chrono::steady_clock::now();
+        frame_start_cycles = cpu->get_cycles();
+        fast_forward_time = std::chrono::steady_clock::duration::zero();
+        frame_idle_cycles = 0;
+    }
 }
 
 void NES::strobe_joypad()
@@ -50,7 +134,11 @@ void NES::strobe_joypad()
 
     SDL_PollEvent(&event);
 
-    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+    if (event.type == SDL_QUIT)
+    {
+        schedule_event(HaltEvent);
+    }
+    else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
     {
         if (keyboard_state[SDL_GetScancodeFromKey(SDLK_x)])
         {
@@ -98,28 +186,388 @@ uint8_t NES::get_key()
     return key | 0x40u;
 }
 
-void NES::run()
+void NES::raise_fault(const Fault_Code code, const uint16_t address, const uint8_t byte)
+{
+    if (fault.code != NoFault)
+    {
+        return;
+    }
+
+    fault = { code, address, byte, cpu->get_instruction_pc(), cpu->get_cycles() };
+
+    schedule_event(HaltEvent);
+}
+
+void NES::report_fault() const
+{
+    static const char *fault_messages[] = {
+            "",
+            "[2A03] Unknown opcode!",
+            "[MMU] Unhandled IO read!",
+            "[MMU] Invalid byte read!",
+            "[MMU] Unhandled IO write!",
+            "[MMU] Invalid byte store!",
+            "[PPU] Write to invalid register!"
+    };
+
+    printf("\n[Ciel] Runtime error!\n");
+    printf("%s\n", fault_messages[fault.code]);
+    printf("[Ciel] Address: %04Xh, byte: %02Xh, PC: %04Xh, cycle: %" PRIu64 "\n", fault.address, fault.byte, fault.pc,
+           fault.cycle);
+}
+
+void NES::schedule_event(const Event_Type type, const uint64_t delay)
+{
+    scheduler.schedule(type, delay);
+}
+
+void NES::handle_events()
+{
+    Event_Type type;
+
+    while (scheduler.pop_due_event(type))
+    {
+        switch (type)
+        {
+            case JoypadEvent:
+                // a strobed joypad reloads its buttons after every step until the strobe is cleared
+                if (strobe != 0)
+                {
+                    strobe_joypad();
+                    schedule_event(JoypadEvent, cpu_clock_divider);
+                }
+                break;
+            case PPUSyncEvent:
+                catch_up_ppu();
+                break;
+            case HaltEvent:
+                halted = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void NES::load_palette(const char *path)
+{
+    palette.load_file(path);
+}
+
+void NES::set_pixel_format(const Pixel_Format format)
+{
+    pixel_format = format;
+    pixels.resize(256 * 240 * Palette::bytes_per_pixel(format));
+
+    SDL_DestroyTexture(texture);
+    texture = SDL_CreateTexture(renderer, get_sdl_format(format), SDL_TEXTUREACCESS_STREAMING, 256, 240);
+}
+
+void NES::enable_trace(const char *path)
+{
+    cpu->enable_trace(path);
+}
+
+void NES::enable_block_translation(const bool enabled)
+{
+    if (stepping_mode != InstructionStepped)
+    {
+        throw std::runtime_error("[Ciel] Block translation needs the instruction-stepped core!");
+    }
+
+    // blocks run the same instructions as stepping, so this can be switched at any time
+    block_translation = enabled;
+
+    printf("[Ciel] Block translation %s\n", enabled ? "enabled" : "disabled");
+}
+
+void NES::load_recompiled(const char *path)
+{
+    if (stepping_mode != InstructionStepped)
+    {
+        throw std::runtime_error("[Ciel] Recompiled code needs the instruction-stepped core!");
+    }
+
+    recompiled_module = SDL_LoadObject(path);
+
+    if (recompiled_module == nullptr)
+    {
+        throw std::runtime_error("[Ciel] Couldn't load recompiled module!");
+    }
+
+    const auto get_module = (Recompiled_Module_Getter)SDL_LoadFunction(recompiled_module, recompiled_module_symbol);
+
+    if (get_module == nullptr)
+    {
+        throw std::runtime_error("[Ciel] Recompiled module has no entry points!");
+    }
+
+    cpu->attach_recompiled(get_module());
+
+    // routines are entered where blocks would be, code they don't cover is still translated
+    block_translation = true;
+
+    printf("[Ciel] Loaded recompiled module \"%s\"\n", path);
+}
+
+void NES::enable_idle_skipping()
+{
+    idle_skipping = true;
+
+    frame_start = std::chrono::steady_clock::now();
+    frame_start_cycles = cpu->get_cycles();
+
+    printf("[Ciel] Idle-loop skipping enabled\n");
+}
+
+void NES::enable_idiom_fusing()
+{
+    idiom_fusing = true;
+
+    printf("[Ciel] Idiom fusing enabled\n");
+}
+
+void NES::enable_frame_skip(const uint8_t skipped, const uint8_t period)
+{
+    ppu->set_frame_skip(skipped, period);
+
+    printf("[Ciel] Frame skipping enabled, %u of every %u frames aren't drawn\n", skipped, period);
+}
+
+void NES::catch_up_ppu()
+{
+    if (stepping_mode != InstructionStepped)
+    {
+        return;
+    }
+
+    // in lockstep, the PPU has run one dot past the start of the cycle the CPU performs its bus access on
+    const uint64_t target_dots = cpu_clock_divider * (cpu->get_cycles() - cycle_base) / ppu_clock_divider + 1u;
+
+    if (ppu_dots >= target_dots)
+    {
+        return;
+    }
+
+    ppu->run_cycles(target_dots - ppu_dots);
+    ppu_dots = target_dots;
+
+    schedule_ppu_sync();
+}
+
+void NES::schedule_ppu_sync()
+{
+    if (stepping_mode != InstructionStepped)
+    {
+        return;
+    }
+
+    // the PPU is left behind until it could raise an NMI, which also covers finishing a frame
+    const uint64_t deadline = ppu_clock_divider * (ppu_dots + ppu->dots_until_nmi() - 1u);
+
+    scheduler.schedule(PPUSyncEvent, (deadline > scheduler.master_clock) ? deadline - scheduler.master_clock : 0);
+}
+
+uint64_t NES::fast_forward()
+{
+    // a strobed joypad is polled every step, and pending DMAs and NMIs need the CPU stepped
+    if (strobe != 0 || mmu->oam_dma || mmu->nmi_pending)
+    {
+        return 0;
+    }
+
+    uint8_t loop_cycles = 0;
+    uint64_t cycle_budget = 0;
+    uint64_t skipped_cycles = 0;
+
+    if (idle_skipping)
+    {
+        loop_cycles = cpu->idle_loop_cycles();
+    }
+
+    if (stepping_mode == InstructionStepped && loop_cycles == 0)
+    {
+        // fused idioms only touch RAM, so they may run up to the next point the PPU is synchronized at
+        const uint64_t sync_clock = scheduler.master_clock + ppu_clock_divider;
+
+        if (scheduler.next_deadline > sync_clock)
+        {
+            cycle_budget = (scheduler.next_deadline - sync_clock) / cpu_clock_divider;
+        }
+    }
+    else
+    {
+        // idle loops may poll the vblank flag, so the PPU has to be where lockstep would have it
+        catch_up_ppu();
+
+        // NMIs can only be raised from vblank on, so nothing run ahead may reach it
+        const uint32_t dots = ppu->dots_until_vblank();
+
+        cycle_budget = (dots != 0) ? (dots - 1u) / 3u : 0;
+    }
+
+    if (loop_cycles != 0)
+    {
+        // nothing the loop waits on can happen before vblank, so skip whole iterations up to it
+        skipped_cycles = cycle_budget / loop_cycles * loop_cycles;
+
+        cpu->skip_cycles(skipped_cycles);
+    }
+    else if (idiom_fusing)
+    {
+        skipped_cycles = cpu->run_fused_idiom(cycle_budget);
+    }
+
+    if (skipped_cycles == 0)
+    {
+        return 0;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (stepping_mode == InstructionStepped)
+    {
+        catch_up_ppu();
+    }
+    else
+    {
+        // the first dot of the current cycle has already run
+        ppu->run_cycles(3u * skipped_cycles - 1u);
+    }
+
+    if (loop_cycles != 0)
+    {
+        frame_idle_cycles += skipped_cycles;
+        fast_forward_time += std::chrono::steady_clock::now() - start;
+    }
+
+    return skipped_cycles;
+}
+
+uint64_t NES::get_cycles() const
+{
+    return cpu->get_cycles();
+}
+
+uint64_t NES::get_recompiled_cycles() const
+{
+    return cpu->get_recompiled_cycles();
+}
+
+const uint8_t *NES::get_ram() const
+{
+    return mmu->get_ram();
+}
+
+const uint16_t *NES::get_framebuffer() const
+{
+    return ppu->framebuffer.data();
+}
+
+void NES::step_cycle()
+{
+    ppu->run_cycle();
+
+    if (idle_skipping || idiom_fusing)
+    {
+        const uint64_t skipped_cycles = fast_forward();
+
+        if (skipped_cycles != 0)
+        {
+            scheduler.master_clock += cpu_clock_divider * skipped_cycles;
+            return;
+        }
+    }
+
+    cpu->run_cycle();
+    ppu->run_cycle();
+    ppu->run_cycle();
+
+    scheduler.master_clock += cpu_clock_divider;
+}
+
+void NES::step_instruction()
+{
+    uint64_t cycles = 0;
+
+    if (idle_skipping || idiom_fusing)
+    {
+        cycles = fast_forward();
+    }
+
+    if (cycles == 0)
+    {
+        cycles = cpu->run_instruction();
+    }
+
+    scheduler.master_clock += cpu_clock_divider * cycles;
+}
+
+void NES::step_block()
 {
-    while (cpu->is_running)
+    // idle loops and fused idioms are loops, which start blocks once they have gone around
+    if (idle_skipping || idiom_fusing)
     {
-        try
+        const uint64_t cycles = fast_forward();
+
+        if (cycles != 0)
         {
-            ppu->run_cycle();
-            cpu->run_cycle();
-            ppu->run_cycle();
-            ppu->run_cycle();
+            scheduler.master_clock += cpu_clock_divider * cycles;
+            return;
+        }
+    }
+
+    cpu->run_block(scheduler);
+}
+
+void NES::run(const uint64_t frame_count)
+{
+    frame_target = (frame_count != 0) ? frames + frame_count : 0;
+
+    run_until_halted();
+}
+
+void NES::run_cycles(const uint64_t cycle_count)
+{
+    frame_target = 0;
+
+    schedule_event(HaltEvent, cpu_clock_divider * cycle_count);
+    run_until_halted();
+}
+
+void NES::run_until_halted()
+{
+    halted = fault.code != NoFault;
 
-            if (strobe != 0)
+    while (!halted)
+    {
+        if (stepping_mode == InstructionStepped && block_translation)
+        {
+            while (scheduler.master_clock < scheduler.next_deadline)
             {
-                strobe_joypad();
+                step_block();
             }
         }
-        catch (const std::runtime_error& error)
+        else if (stepping_mode == InstructionStepped)
         {
-            printf("\n[Ciel] Runtime error!\n");
-            printf("%s\n", error.what());
-
-            cpu->is_running = false;
+            while (scheduler.master_clock < scheduler.next_deadline)
+            {
+                step_instruction();
+            }
+        }
+        else
+        {
+            while (scheduler.master_clock < scheduler.next_deadline)
+            {
+                step_cycle();
+            }
         }
+
+        handle_events();
+    }
+
+    if (fault.code != NoFault)
+    {
+        report_fault();
     }
 }
\ No newline at end of file
@@ -3,14 +3,26 @@
 #define CIEL_NES_H
 
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include "SDL2/SDL.h"
 
+#include "fault.h"
+#include "scheduler.h"
+#include "ppu/palette.h"
+
 class CPU;
 class MMU;
 class PPU;
 
+enum Stepping_Mode
+{
+    CycleStepped,
+    InstructionStepped
+};
+
 class NES
 {
 private:
@@ -18,24 +30,90 @@ private:
     std::shared_ptr<PPU> ppu;
     std::unique_ptr<CPU> cpu;
 
+    Stepping_Mode stepping_mode;
+    Scheduler scheduler;
+    uint64_t cycle_base;
+    uint64_t ppu_dots;
+
+    // the first fault since reset, it halts the run loop through the scheduler instead of unwinding it
+    Fault fault;
+    bool halted;
+
+    uint64_t frames;
+    uint64_t frame_target;
+
+    bool block_translation;
+    void *recompiled_module;
+    bool idle_skipping;
+    bool idiom_fusing;
+    uint64_t frame_start_cycles;
+    uint64_t frame_idle_cycles;
+    uint64_t total_idle_cycles;
+    double total_idle_time_saved;
+    std::chrono::steady_clock::time_point frame_start;
+    std::chrono::steady_clock::duration fast_forward_time;
+
+    Palette palette;
+    Pixel_Format pixel_format;
+    std::vector<uint8_t> pixels;
+
     SDL_Renderer *renderer;
     SDL_Window *window;
     SDL_Texture *texture;
     SDL_Event event;
+
+    void run_until_halted();
 public:
-    explicit NES(const char *cartridge_path);
+    explicit NES(const char *cartridge_path, Stepping_Mode stepping_mode = CycleStepped);
     ~NES();
 
     uint8_t joy;
     uint8_t strobe;
 
+    // idle-loop counters for the last completed frame, the current one is counted separately until it is finished
+    uint64_t idle_cycles_skipped;
+    double idle_time_saved;
+
     void init_sdl();
-    void update_framebuffer(const uint8_t *framebuffer);
+    void update_framebuffer(const uint16_t *framebuffer);
 
     void strobe_joypad();
     uint8_t get_key();
 
-    void run();
+    void raise_fault(Fault_Code code, uint16_t address, uint8_t byte = 0);
+    void report_fault() const;
+
+    void schedule_event(Event_Type type, uint64_t delay = 0);
+    void handle_events();
+
+    void load_palette(const char *path);
+    void set_pixel_format(Pixel_Format format);
+    void enable_trace(const char *path);
+    void enable_block_translation(bool enabled);
+    void load_recompiled(const char *path);
+    void enable_idle_skipping();
+    void enable_idiom_fusing();
+    void enable_frame_skip(uint8_t skipped, uint8_t period);
+
+    void catch_up_ppu();
+    void schedule_ppu_sync();
+    uint64_t fast_forward();
+
+    [[nodiscard]] uint64_t get_cycles() const;
+    // spent in a recompiled module's routines
+    [[nodiscard]] uint64_t get_recompiled_cycles() const;
+    [[nodiscard]] const uint8_t *get_ram() const;
+    [[nodiscard]] const uint16_t *get_framebuffer() const;
+
+    void step_cycle();
+    void step_instruction();
+    void step_block();
+
+    // runs until frame_count more frames are finished, or with no limit when it is 0, a fault always ends the run
+    void run(uint64_t frame_count = 0);
+
+    // runs for at least cycle_count CPU cycles, instructions and blocks aren't split so it can overshoot by a few
+    void run_cycles(uint64_t cycle_count);
 };
 
 
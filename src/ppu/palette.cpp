@@ -0,0 +1,167 @@
+#include "palette.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+const uint8_t palette_data[64][3] = {
+        // 0h, ...
+        { 0x66, 0x66, 0x66 }, { 0x00, 0x2A, 0x88 }, { 0x14, 0x12, 0xA7 }, { 0x3B, 0x00, 0xA4 },
+        { 0x5C, 0x00, 0x7E }, { 0x6E, 0x00, 0x40 }, { 0x6C, 0x06, 0x00 }, { 0x56, 0x1D, 0x00 },
+        { 0x33, 0x35, 0x00 }, { 0x0B, 0x48, 0x00 }, { 0x00, 0x52, 0x00 }, { 0x00, 0x4F, 0x08 },
+        { 0x00, 0x40, 0x4D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        // 10h, ...
+        { 0xAD, 0xAD, 0xAD }, { 0x15, 0x5F, 0xD9 }, { 0x42, 0x40, 0xFF }, { 0x75, 0x27, 0xFE },
+        { 0xA0, 0x1A, 0xCC }, { 0xB7, 0x1E, 0x7B }, { 0xB5, 0x31, 0x20 }, { 0x99, 0x4E, 0x00 },
+        { 0x6B, 0x6D, 0x00 }, { 0x38, 0x87, 0x00 }, { 0x0C, 0x93, 0x00 }, { 0x00, 0x8F, 0x32 },
+        { 0x00, 0x7C, 0x8D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        // 20h, ...
+        { 0xFF, 0xFE, 0xFF }, { 0x64, 0xB0, 0xFF }, { 0x92, 0x90, 0xFF }, { 0xC6, 0x76, 0xFF },
+        { 0xF3, 0x6A, 0xFF }, { 0xFE, 0x6E, 0xCC }, { 0xFE, 0x81, 0x70 }, { 0xEA, 0x9E, 0x22 },
+        { 0xBC, 0xBE, 0x00 }, { 0x88, 0xD8, 0x00 }, { 0x5C, 0xE4, 0x30 }, { 0x45, 0xE0, 0x82 },
+        { 0x48, 0xCD, 0xDE }, { 0x4F, 0x4F, 0x4F }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        // 30h, ...
+        { 0xFF, 0xFE, 0xFF }, { 0xC0, 0xDF, 0xFF }, { 0xD3, 0xD2, 0xFF }, { 0xE8, 0xC8, 0xFF },
+        { 0xFB, 0xC2, 0xFF }, { 0xFE, 0xC4, 0xEA }, { 0xFE, 0xCC, 0xC5 }, { 0xF7, 0xD8, 0xA5 },
+        { 0xE4, 0xE5, 0x94 }, { 0xCF, 0xEF, 0x96 }, { 0xBD, 0xF4, 0xAB }, { 0xB3, 0xF3, 0xCC },
+        { 0xB5, 0xEB, 0xF2 }, { 0xB8, 0xB8, 0xB8 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }
+};
+
+const double emphasis_attenuation = 0.816328;
+
+Palette::Palette() :
+rgb(), xrgb(), rgb565()
+{
+    emphasize(&palette_data[0][0]);
+    build_tables();
+}
+
+void Palette::load_file(const char *path)
+{
+    printf("[Palette] Loading file \"%s\"...\n", path);
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("[Palette] Couldn't open file!");
+    }
+
+    file.unsetf(std::ios::skipws);
+
+    const std::vector<uint8_t> data((std::istream_iterator<uint8_t>(file)), std::istream_iterator<uint8_t>());
+
+    if (data.size() == 3 * 512)
+    {
+        for (uint16_t index = 0; index < 512; index++)
+        {
+            rgb[index][0] = data[3 * index];
+            rgb[index][1] = data[3 * index + 1];
+            rgb[index][2] = data[3 * index + 2];
+        }
+    }
+    else if (data.size() == 3 * 64)
+    {
+        emphasize(data.data());
+    }
+    else
+    {
+        throw std::runtime_error("[Palette] Palette has to hold 64 or 512 colors!");
+    }
+
+    build_tables();
+
+    printf("[Palette] Successfully loaded \"%s\"!\n", path);
+}
+
+void Palette::emphasize(const uint8_t *colors)
+{
+    for (uint16_t index = 0; index < 512; index++)
+    {
+        const uint8_t color = index & 0x3fu;
+        const uint8_t emphasis = index >> 6u;
+
+        for (uint8_t channel = 0; channel < 3; channel++)
+        {
+            double value = colors[3 * color + channel];
+
+            // any emphasis bit darkens the other two channels, the black columns don't respond to it
+            if ((emphasis & ~(1u << channel)) != 0 && (color & 0xfu) < 0xe)
+            {
+                value *= emphasis_attenuation;
+            }
+
+            rgb[index][channel] = (uint8_t)value;
+        }
+    }
+}
+
+void Palette::build_tables()
+{
+    for (uint16_t index = 0; index < 512; index++)
+    {
+        const uint8_t r = rgb[index][0];
+        const uint8_t g = rgb[index][1];
+        const uint8_t b = rgb[index][2];
+
+        xrgb[index] = (r << 16u) | (g << 8u) | b;
+        rgb565[index] = ((r >> 3u) << 11u) | ((g >> 2u) << 5u) | (b >> 3u);
+    }
+}
+
+uint8_t Palette::bytes_per_pixel(const Pixel_Format format)
+{
+    switch (format)
+    {
+        case XRGB8888:
+            return 4;
+        case RGB565:
+            return 2;
+        default:
+            return 3;
+    }
+}
+
+void Palette::convert(const uint16_t *frame, const Pixel_Format format, void *pixels) const
+{
+    // one table load and store per pixel, emphasis is part of the index
+    switch (format)
+    {
+        case XRGB8888:
+        {
+            auto *out = (uint32_t *)pixels;
+
+            for (uint32_t pixel = 0; pixel < 256 * 240; pixel++)
+            {
+                out[pixel] = xrgb[frame[pixel] & 0x1ffu];
+            }
+            break;
+        }
+        case RGB565:
+        {
+            auto *out = (uint16_t *)pixels;
+
+            for (uint32_t pixel = 0; pixel < 256 * 240; pixel++)
+            {
+                out[pixel] = rgb565[frame[pixel] & 0x1ffu];
+            }
+            break;
+        }
+        default:
+        {
+            auto *out = (uint8_t *)pixels;
+
+            for (uint32_t pixel = 0; pixel < 256 * 240; pixel++)
+            {
+                const uint8_t *color = rgb[frame[pixel] & 0x1ffu];
+
+                out[3 * pixel] = color[0];
+                out[3 * pixel + 1] = color[1];
+                out[3 * pixel + 2] = color[2];
+            }
+            break;
+        }
+    }
+}
\ No newline at end of file
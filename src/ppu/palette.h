@@ -0,0 +1,39 @@
+#pragma once
+#ifndef CIEL_PALETTE_H
+#define CIEL_PALETTE_H
+
+
+#include <cstdint>
+
+enum Pixel_Format
+{
+    RGB24,
+    XRGB8888,
+    RGB565
+};
+
+// turns the PPU's frames of palette indices into host pixels, a frame holds 256 * 240 entries with the NES color in
+// bits 0-5 and the PPUMASK emphasis bits in bits 6-8
+class Palette
+{
+private:
+    // one entry per color and emphasis combination, only rebuilt when a palette is loaded
+    uint8_t rgb[512][3];
+    uint32_t xrgb[512];
+    uint16_t rgb565[512];
+
+    void emphasize(const uint8_t *colors);
+    void build_tables();
+public:
+    Palette();
+
+    // takes .pal files of 64 colors, or of 512 when they already hold every emphasis combination
+    void load_file(const char *path);
+
+    [[nodiscard]] static uint8_t bytes_per_pixel(Pixel_Format format);
+
+    void convert(const uint16_t *frame, Pixel_Format format, void *pixels) const;
+};
+
+
+#endif //CIEL_PALETTE_H
@@ -2,39 +2,21 @@
 
 #include "..//mmu/mmu.h"
 
-const uint8_t palette_data[64][3] = {
-        // 0h, ...
-        { 0x66, 0x66, 0x66 }, { 0x00, 0x2A, 0x88 }, { 0x14, 0x12, 0xA7 }, { 0x3B, 0x00, 0xA4 },
-        { 0x5C, 0x00, 0x7E }, { 0x6E, 0x00, 0x40 }, { 0x6C, 0x06, 0x00 }, { 0x56, 0x1D, 0x00 },
-        { 0x33, 0x35, 0x00 }, { 0x0B, 0x48, 0x00 }, { 0x00, 0x52, 0x00 }, { 0x00, 0x4F, 0x08 },
-        { 0x00, 0x40, 0x4D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
-        // 10h, ...
-        { 0xAD, 0xAD, 0xAD }, { 0x15, 0x5F, 0xD9 }, { 0x42, 0x40, 0xFF }, { 0x75, 0x27, 0xFE },
-        { 0xA0, 0x1A, 0xCC }, { 0xB7, 0x1E, 0x7B }, { 0xB5, 0x31, 0x20 }, { 0x99, 0x4E, 0x00 },
-        { 0x6B, 0x6D, 0x00 }, { 0x38, 0x87, 0x00 }, { 0x0C, 0x93, 0x00 }, { 0x00, 0x8F, 0x32 },
-        { 0x00, 0x7C, 0x8D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
-        // 20h, ...
-        { 0xFF, 0xFE, 0xFF }, { 0x64, 0xB0, 0xFF }, { 0x92, 0x90, 0xFF }, { 0xC6, 0x76, 0xFF },
-        { 0xF3, 0x6A, 0xFF }, { 0xFE, 0x6E, 0xCC }, { 0xFE, 0x81, 0x70 }, { 0xEA, 0x9E, 0x22 },
-        { 0xBC, 0xBE, 0x00 }, { 0x88, 0xD8, 0x00 }, { 0x5C, 0xE4, 0x30 }, { 0x45, 0xE0, 0x82 },
-        { 0x48, 0xCD, 0xDE }, { 0x4F, 0x4F, 0x4F }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
-        // 30h, ...
-        { 0xFF, 0xFE, 0xFF }, { 0xC0, 0xDF, 0xFF }, { 0xD3, 0xD2, 0xFF }, { 0xE8, 0xC8, 0xFF },
-        { 0xFB, 0xC2, 0xFF }, { 0xFE, 0xC4, 0xEA }, { 0xFE, 0xCC, 0xC5 }, { 0xF7, 0xD8, 0xA5 },
-        { 0xE4, 0xE5, 0x94 }, { 0xCF, 0xEF, 0x96 }, { 0xBD, 0xF4, 0xAB }, { 0xB3, 0xF3, 0xCC },
-        { 0xB5, 0xEB, 0xF2 }, { 0xB8, 0xB8, 0xB8 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }
-};
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 PPU::PPU(const std::shared_ptr<MMU> &mmu) :
-regs(), s_regs(), bg(), spr(), internal_bus(0), ppu_cycle(0), scanline(0), first_write(true), suppress_vblank_flag(false),
-even_frame(true)
+regs(), s_regs(), bg(), spr(), chr_pages(), chr_write_pages(), nt_pages(), uncached_row(), internal_bus(0), ppu_cycle(0), scanline(0), first_write(true), suppress_vblank_flag(false),
+even_frame(true), frame_output(true), skipped_frames(0), frame_period(0), frame_number(0)
 {
     this->mmu = mmu;
 
     oam.resize(0x100);
     oam_2.resize(0x20);
     vram.resize(0x2000);
-    framebuffer.resize(3 * 256 * 240);
+    chr_rows.resize(0x1000);
+    framebuffer.resize(256 * 240);
 }
 
 PPU::~PPU()
@@ -56,6 +38,8 @@ void PPU::tick()
         }
 
         ++scanline;
+
+        spr.line_ready = false;
     }
 
     if (scanline == 262)
@@ -96,8 +80,6 @@ void PPU::x_increment()
 
 void PPU::y_increment()
 {
-    static uint8_t coarse_y;
-
     if ((s_regs.v & 0x7000u) != 0x7000)
     {
         s_regs.v += 0x1000u;
@@ -105,7 +87,8 @@ void PPU::y_increment()
     else
     {
         s_regs.v &= ~(0x7000u);
-        coarse_y = (s_regs.v & 0x3e0u) >> 5u;
+
+        uint8_t coarse_y = (s_regs.v & 0x3e0u) >> 5u;
 
         if (coarse_y == 29)
         {
@@ -134,11 +117,11 @@ uint8_t PPU::read_memory(const uint16_t address)
 {
     if (address < 0x2000)
     {
-        return mmu->read_chr(address);
+        return chr_pages[address >> 10u][address & 0x3ffu];
     }
     else if (address >= 0x2000 && address < 0x3f00)
     {
-        return vram[mmu->get_nt_addr(address)];
+        return nt_pages[(address >> 10u) & 0x3u][address & 0x3ffu];
     }
 
     return vram[address - 0x2000u];
@@ -146,9 +129,22 @@ uint8_t PPU::read_memory(const uint16_t address)
 
 void PPU::write_memory(const uint8_t byte)
 {
+    spr.line_ready = false;
+
     if (s_regs.v < 0x2000)
     {
-        mmu->write_chr(byte, s_regs.v);
+        uint8_t *page = chr_write_pages[s_regs.v >> 10u];
+
+        if (page != nullptr)
+        {
+            page[s_regs.v & 0x3ffu] = byte;
+        }
+
+        chr_rows[((s_regs.v & 0x1ff0u) >> 1u) | (s_regs.v & 0x7u)].valid = false;
+    }
+    else if (s_regs.v < 0x3f00)
+    {
+        nt_pages[(s_regs.v >> 10u) & 0x3u][s_regs.v & 0x3ffu] = byte;
     }
     else
     {
@@ -163,6 +159,84 @@ void PPU::write_memory(const uint8_t byte)
     }
 }
 
+void PPU::decode_chr_row(CHR_Row &row, const uint16_t address)
+{
+    row.low = read_memory(address);
+    row.high = read_memory(address + 8);
+    row.pixels = 0;
+    row.flipped_pixels = 0;
+
+    for (uint8_t pixel = 0; pixel < 8; pixel++)
+    {
+        const uint64_t type = ((row.low >> (7u - pixel)) & 1u) | (((row.high >> (7u - pixel)) & 1u) << 1u);
+
+        row.pixels |= type << (8u * pixel);
+        row.flipped_pixels |= type << (8u * (7u - pixel));
+    }
+
+    row.valid = true;
+}
+
+const CHR_Row &PPU::read_chr_row(const uint16_t address)
+{
+    // rows starting in a tile's high plane or outside CHR only come up when the sprite size changes mid-line
+    if ((address & 0x8u) || address >= 0x2000)
+    {
+        decode_chr_row(uncached_row, address);
+        return uncached_row;
+    }
+
+    CHR_Row &row = chr_rows[((address & 0x1ff0u) >> 1u) | (address & 0x7u)];
+
+    if (!row.valid)
+    {
+        decode_chr_row(row, address);
+    }
+
+    return row;
+}
+
+void PPU::set_frame_skip(const uint8_t skipped, const uint8_t period)
+{
+    skipped_frames = skipped;
+    frame_period = period;
+    frame_number = 0;
+    frame_output = skipped == 0;
+}
+
+void PPU::map_chr(const uint8_t page, const uint8_t *read_page, uint8_t *write_page)
+{
+    chr_pages[page] = read_page;
+    chr_write_pages[page] = write_page;
+}
+
+void PPU::map_nametables(const Mirroring mirroring)
+{
+    // the nametables live in the first 4 KiB of vram, four-screen boards use all of it
+    static const uint8_t layouts[5][4] = {
+            { 0, 0, 1, 1 }, // horizontal
+            { 0, 1, 0, 1 }, // vertical
+            { 0, 0, 0, 0 }, // single-screen, lower bank
+            { 1, 1, 1, 1 }, // single-screen, upper bank
+            { 0, 1, 2, 3 }  // four-screen
+    };
+
+    for (uint8_t table = 0; table < 4; table++)
+    {
+        nt_pages[table] = &vram[0x400u * layouts[mirroring][table]];
+    }
+}
+
+void PPU::invalidate_chr_rows()
+{
+    for (CHR_Row &row : chr_rows)
+    {
+        row.valid = false;
+    }
+
+    spr.line_ready = false;
+}
+
 void PPU::background_fetch()
 {
     if (ppu_cycle == 0)
@@ -176,7 +250,7 @@ void PPU::background_fetch()
             case 0:
                 bg.tile_address = ((uint16_t)(regs.ppuctrl >> 4u) & 1u) * 0x1000u +
                                   bg.nametable_byte * 16u + ((uint16_t)(s_regs.v >> 12u) & 0x7u);
-                bg.tile_high = read_memory(bg.tile_address + 8);
+                bg.tile_high = read_chr_row(bg.tile_address).high;
 
                 if (is_rendering())
                 {
@@ -212,7 +286,7 @@ void PPU::background_fetch()
             case 6:
                 bg.tile_address = ((uint16_t)(regs.ppuctrl >> 4u) & 1u) * 0x1000u +
                                   bg.nametable_byte * 16u + ((uint16_t)(s_regs.v >> 12u) & 0x7u);
-                bg.tile_low = read_memory(bg.tile_address);
+                bg.tile_low = read_chr_row(bg.tile_address).low;
                 break;
         }
     }
@@ -285,6 +359,8 @@ void PPU::sprite_fetch()
                 }
             }
         }
+
+        spr.line_ready = false;
     }
 
     if (ppu_cycle >= 257 && ppu_cycle < 321)
@@ -341,15 +417,132 @@ void PPU::sprite_fetch()
     }
 }
 
-Pixel PPU::background_pixel()
+void PPU::render_background_line()
 {
-    static uint8_t palette;
-    static uint8_t type;
+    // pixel c shows the shifters after max(c, 1) - 1 shifts, so it's bit x + max(c, 1) - 2 of the stream of every
+    // tile the line shifts through, starting with the bits the shifters already hold
+    uint8_t stream[8 + 34 * 8];
+    uint8_t pattern[2];
+    uint8_t palette[2];
+
+    for (uint8_t position = 0; position < 17; position++)
+    {
+        // the shifters hold the first 8 pixels after one bit of the tile before, the latched tile follows them
+        if (position < 9)
+        {
+            pattern[0] = (uint8_t)(bg.tile_shifter[0] >> (15u - position)) & 1u;
+            pattern[1] = (uint8_t)(bg.tile_shifter[1] >> (15u - position)) & 1u;
+        }
+        else
+        {
+            pattern[0] = (uint8_t)(bg.tile_low >> (16u - position)) & 1u;
+            pattern[1] = (uint8_t)(bg.tile_high >> (16u - position)) & 1u;
+        }
+
+        if (position < 8)
+        {
+            palette[0] = (uint8_t)(bg.at_shifter[0] >> (7u - position)) & 1u;
+            palette[1] = (uint8_t)(bg.at_shifter[1] >> (7u - position)) & 1u;
+        }
+        else if (position == 8)
+        {
+            palette[0] = bg.at_latch[0];
+            palette[1] = bg.at_latch[1];
+        }
+        else
+        {
+            palette[0] = bg.attribute_byte & 0x1u;
+            palette[1] = (bg.attribute_byte >> 1u) & 0x1u;
+        }
+
+        stream[7 + position] = (uint8_t)(palette[1] << 3u) | (uint8_t)(palette[0] << 2u) | (uint8_t)(pattern[1] << 1u) |
+                               pattern[0];
+    }
+
+    const uint16_t pattern_table = ((uint16_t)(regs.ppuctrl >> 4u) & 1u) * 0x1000u;
+    uint8_t tile_attributes[2] {};
+    uint8_t tile_patterns[2][2] {};
 
-    palette = (((uint8_t)(bg.at_shifter[1] >> (7u - s_regs.x)) & 1u) << 1u) |
-              (((uint8_t)(bg.at_shifter[0] >> (7u - s_regs.x)) & 1u));
-    type = (((uint8_t)(bg.tile_shifter[1] >> (15u - s_regs.x)) & 1u) << 1u) |
-           (((uint8_t)(bg.tile_shifter[0] >> (15u - s_regs.x)) & 1u));
+    // the same fetches dots 2 to 256 make, one tile per 8 dots
+    for (uint8_t tile = 1; tile <= 32; tile++)
+    {
+        bg.nametable_address = 0x2000u | (s_regs.v & 0xfffu);
+        bg.nametable_byte = read_memory(bg.nametable_address);
+
+        bg.attribute_address = 0x23c0u | ((s_regs.v) & 0xc00u) |
+                               ((uint16_t)(s_regs.v >> 4u) & 0x38u) | ((uint16_t)(s_regs.v >> 2u) & 0x7u);
+        bg.attribute_byte = read_memory(bg.attribute_address);
+
+        if ((uint8_t)(s_regs.v >> 5u) & 2u)
+        {
+            bg.attribute_byte >>= 4u;
+        }
+        if (s_regs.v & 2u)
+        {
+            bg.attribute_byte >>= 2u;
+        }
+
+        bg.tile_address = pattern_table + bg.nametable_byte * 16u + ((uint16_t)(s_regs.v >> 12u) & 0x7u);
+
+        const CHR_Row &row = read_chr_row(bg.tile_address);
+
+        bg.tile_low = row.low;
+        bg.tile_high = row.high;
+
+        x_increment();
+
+        if (tile == 32)
+        {
+            break;
+        }
+
+        // the last two tiles are left in the shifters
+        tile_attributes[0] = tile_attributes[1];
+        tile_attributes[1] = bg.attribute_byte & 0x3u;
+        tile_patterns[0][0] = tile_patterns[1][0];
+        tile_patterns[0][1] = tile_patterns[1][1];
+        tile_patterns[1][0] = bg.tile_low;
+        tile_patterns[1][1] = bg.tile_high;
+
+        // all 8 pixels at once, each byte gets the palette above its type
+        const uint64_t pixels = row.pixels | (tile_attributes[1] * 0x0404040404040404u);
+
+        std::memcpy(&stream[8 * (tile + 2)], &pixels, sizeof(pixels));
+    }
+
+    y_increment();
+
+    for (uint8_t plane = 0; plane < 2; plane++)
+    {
+        bg.tile_shifter[plane] = (uint16_t)(((tile_patterns[0][plane] << 8u) | tile_patterns[1][plane]) << 7u);
+        bg.at_shifter[plane] = (uint8_t)((((tile_attributes[0] >> plane) & 1u) << 7u) |
+                                         (((tile_attributes[1] >> plane) & 1u) ? 0x7fu : 0));
+        bg.at_latch[plane] = (tile_attributes[1] >> plane) & 1u;
+    }
+
+    const bool show_background = (regs.ppumask & 0x8u) != 0;
+    const bool show_left_background = (regs.ppumask & 0x2u) != 0;
+
+    for (uint16_t dot = ppu_cycle; dot <= 256; dot++)
+    {
+        // the stream entries already are palette * 4 + type
+        bg.line[dot] = stream[6 + s_regs.x + ((dot != 0) ? dot : 1)];
+
+        if (!show_background || (!show_left_background && dot < 8))
+        {
+            bg.line[dot] = 0;
+        }
+    }
+
+    bg.line_ready = true;
+}
+
+Pixel PPU::background_pixel()
+{
+    const uint8_t palette = (((uint8_t)(bg.at_shifter[1] >> (7u - s_regs.x)) & 1u) << 1u) |
+                            (((uint8_t)(bg.at_shifter[0] >> (7u - s_regs.x)) & 1u));
+    const uint8_t type = (((uint8_t)(bg.tile_shifter[1] >> (15u - s_regs.x)) & 1u) << 1u) |
+                         (((uint8_t)(bg.tile_shifter[0] >> (15u - s_regs.x)) & 1u));
 
     if ((ppu_cycle >= 1 && ppu_cycle < 257) || (ppu_cycle >= 321 && ppu_cycle < 337))
     {
@@ -371,17 +564,12 @@ Pixel PPU::background_pixel()
         return Pixel(false, 0, false);
     }
 
-    return Pixel(type, read_memory(0x3f00u + palette * 4u + type), false);
+    return Pixel(type, frame_output ? read_memory(0x3f00u + palette * 4u + type) : 0, false);
 }
 
-Pixel PPU::sprite_pixel(Pixel &bg_pixel)
+void PPU::render_sprite_line()
 {
-    const int x = ppu_cycle;
-
-    if (((regs.ppumask & 0x10u) == 0) || (((regs.ppumask & 0x4u) == 0) && x < 8))
-    {
-        return Pixel(false, 0, false);
-    }
+    std::memset(spr.line, 0, sizeof(spr.line));
 
     for (uint8_t sprite = 0; sprite < 8; sprite++)
     {
@@ -395,15 +583,7 @@ Pixel PPU::sprite_pixel(Pixel &bg_pixel)
             break;
         }
 
-        bool x_in_range = in_range(int(x_pos), int(x) - 7, int(x));
-
-        if (!x_in_range)
-        {
-            continue;
-        }
-
         uint16_t spr_row = scanline - y_pos - 1;
-        uint8_t spr_col = 7 - (x - x_pos);
 
         const uint8_t sprite_height = ((regs.ppuctrl & 0x20u) != 0) ? 16 : 8;
 
@@ -412,11 +592,6 @@ Pixel PPU::sprite_pixel(Pixel &bg_pixel)
             spr_row = sprite_height - 1 - spr_row;
         }
 
-        if ((attribute & 0x40u) != 0)
-        {
-            spr_col = 8 - 1 - spr_col;
-        }
-
         bool spr_table = ((regs.ppuctrl & 0x20u) == 0) ? ((regs.ppuctrl & 0x8u) != 0) : tile_index & 1u;
 
         if ((regs.ppuctrl & 0x20u) != 0)
@@ -431,39 +606,67 @@ Pixel PPU::sprite_pixel(Pixel &bg_pixel)
         }
 
         uint16_t tile_addr = (0x1000 * spr_table) + (tile_index * 16) + spr_row;
-        uint8_t lo_bp = read_memory(tile_addr);
-        uint8_t hi_bp = read_memory(tile_addr + 8);
-        uint8_t type = nth_bit(lo_bp, spr_col) + (nth_bit(hi_bp, spr_col) << 1u);
+        const CHR_Row &row = read_chr_row(tile_addr);
+        const uint64_t pixels = ((attribute & 0x40u) != 0) ? row.flipped_pixels : row.pixels;
 
-        if (type == 0)
-        {
-            continue;
-        }
+        const uint8_t flags = ((attribute & 0x7u) << 2u) | ((attribute & 0x20u) ? 0x20u : 0) | ((sprite == 0) ? 0x40u : 0);
 
-        if (sprite == 0 && spr.sprite_zero_on_line && is_rendering() && ((regs.ppustatus & 0x40u) == 0) &&
-                (x_pos != 0xff && x < 0xff) && bg_pixel.is_on)
+        for (uint8_t pixel = 0; pixel < 8 && x_pos + pixel < 256; pixel++)
         {
-            regs.ppustatus |= 0x40u;
+            const uint8_t type = (uint8_t)(pixels >> (8u * pixel)) & 0x3u;
+
+            // lower slots win, so only fill what's still transparent
+            if (type != 0 && (spr.line[x_pos + pixel] & 0x3u) == 0)
+            {
+                spr.line[x_pos + pixel] = flags | type;
+            }
         }
+    }
+
+    spr.line_ready = true;
+}
 
-        return Pixel(true, read_memory(0x3f10 + (attribute & 0x7u) * 4 + type), (attribute & 0x20u) != 0);
+Pixel PPU::sprite_pixel(Pixel &bg_pixel)
+{
+    const int x = ppu_cycle;
+
+    if (((regs.ppumask & 0x10u) == 0) || (((regs.ppumask & 0x4u) == 0) && x < 8) || x >= 256)
+    {
+        return Pixel(false, 0, false);
     }
 
-    return Pixel(false, 0, false);
+    if (!spr.line_ready)
+    {
+        render_sprite_line();
+    }
+
+    const uint8_t entry = spr.line[x];
+
+    if ((entry & 0x3u) == 0)
+    {
+        return Pixel(false, 0, false);
+    }
+
+    if ((entry & 0x40u) && spr.sprite_zero_on_line && is_rendering() && ((regs.ppustatus & 0x40u) == 0) &&
+            x < 0xff && bg_pixel.is_on)
+    {
+        regs.ppustatus |= 0x40u;
+    }
+
+    return Pixel(true, frame_output ? read_memory(0x3f10 + (entry & 0x1fu)) : 0, (entry & 0x20u) != 0);
 }
 
-void PPU::draw_pixel(uint8_t color, uint64_t offset)
+void PPU::draw_pixel(uint8_t color, uint32_t offset)
 {
-    framebuffer[offset] = palette_data[color][0];
-    framebuffer[offset + 1u] = palette_data[color][1];
-    framebuffer[offset + 2u] = palette_data[color][2];
+    // grayscale keeps only the luma column of the color
+    const uint8_t color_mask = ((regs.ppumask & 0x1u) != 0) ? 0x30u : 0x3fu;
+
+    framebuffer[offset] = (color & color_mask) | ((regs.ppumask & 0xe0u) << 1u);
 }
 
 uint8_t PPU::read_ppustatus()
 {
-    static uint8_t old_ppustatus;
-
-    old_ppustatus = (regs.ppustatus & 0xe0u) | (internal_bus & 0x1fu);
+    uint8_t old_ppustatus = (regs.ppustatus & 0xe0u) | (internal_bus & 0x1fu);
     regs.ppustatus &= ~(0x80u);
     first_write = true;
 
@@ -489,7 +692,7 @@ uint8_t PPU::read_ppustatus()
 
 uint8_t PPU::read_ppudata()
 {
-    static uint8_t buffer;
+    uint8_t buffer;
 
     if (s_regs.v < 0x3f00)
     {
@@ -510,6 +713,7 @@ uint8_t PPU::read_ppudata()
 void PPU::write_ppuctrl(const uint8_t byte)
 {
     regs.ppuctrl = byte;
+    spr.line_ready = false;
     s_regs.t = (s_regs.t & 0xf3ffu) | ((byte & 0x3u) << 10u);
 }
 
@@ -617,50 +821,99 @@ void PPU::write_register(const uint8_t byte, const uint16_t address)
             write_ppudata(byte);
             break;
         default:
-            printf("[PPU] Register %04Xh", address + 0x2000);
-            throw std::runtime_error("[PPU] Write to invalid register!");
+            mmu->raise_fault(InvalidPPURegister, address + 0x2000, byte);
+            break;
     }
 
     internal_bus = byte;
 }
 
-void PPU::run_cycle()
+uint32_t PPU::dots_until_vblank() const
 {
-    static uint8_t color;
-    static Pixel bg_pixel = Pixel(false, 0, false);
-    static Pixel spr_pixel = Pixel(false, 0, false);
+    if (regs.ppustatus & 0x80u)
+    {
+        return 0;
+    }
+
+    // counts the dot that sets the flag, which is the first one an NMI can be raised on
+    const uint32_t position = scanline * 341u + ppu_cycle;
+    const uint32_t vblank_position = 241u * 341u + 1u;
+
+    if (position <= vblank_position)
+    {
+        return vblank_position - position + 1u;
+    }
+
+    // the odd frame dot skip can shorten the frame by one, so this errs on the early side
+    return (262u * 341u - position) + vblank_position;
+}
+
+uint32_t PPU::dots_until_nmi() const
+{
+    if ((regs.ppustatus & 0x80u) == 0)
+    {
+        return dots_until_vblank();
+    }
+
+    // NMIs are evaluated every dot of vblank, so enabling them there raises one right away
+    if (regs.ppuctrl & 0x80u)
+    {
+        return 1;
+    }
 
+    // until the next vblank, only a PPUCTRL write could raise one
+    const uint32_t position = scanline * 341u + ppu_cycle;
+
+    return (262u * 341u - position) + 241u * 341u + 1u;
+}
+
+void PPU::run_cycle()
+{
     if (scanline < 240 || scanline == 261)
     {
-        bg_pixel = background_pixel();
-        spr_pixel = sprite_pixel(bg_pixel);
+        Pixel bg_pixel = bg.line_ready ?
+                Pixel((bg.line[ppu_cycle] & 0x3u) != 0, frame_output ? read_memory(0x3f00u + bg.line[ppu_cycle]) : 0, false) :
+                background_pixel();
+        Pixel spr_pixel = sprite_pixel(bg_pixel);
 
         if (is_rendering())
         {
-            background_fetch();
+            if (!bg.line_ready)
+            {
+                background_fetch();
+            }
+
             sprite_fetch();
         }
 
-        if (!bg_pixel.is_on && !spr_pixel.is_on)
-        {
-            color = read_memory(0x3f00);
-        }
-        else if (!bg_pixel.is_on && spr_pixel.is_on)
+        if (bg.line_ready && ppu_cycle == 256)
         {
-            color = spr_pixel.color;
-        }
-        else if (bg_pixel.is_on && !spr_pixel.is_on)
-        {
-            color = bg_pixel.color;
-        }
-        else
-        {
-            color = (spr_pixel.priority) ? bg_pixel.color : spr_pixel.color;
+            bg.line_ready = false;
         }
 
-        if (ppu_cycle < 256 && scanline != 261)
+        // skipped frames still need both pixels for sprite 0 hits, just not their colors
+        if (frame_output && ppu_cycle < 256 && scanline != 261)
         {
-            draw_pixel(color, (256 * 3 * scanline) + (3 * ppu_cycle));
+            uint8_t color;
+
+            if (!bg_pixel.is_on && !spr_pixel.is_on)
+            {
+                color = read_memory(0x3f00);
+            }
+            else if (!bg_pixel.is_on && spr_pixel.is_on)
+            {
+                color = spr_pixel.color;
+            }
+            else if (bg_pixel.is_on && !spr_pixel.is_on)
+            {
+                color = bg_pixel.color;
+            }
+            else
+            {
+                color = (spr_pixel.priority) ? bg_pixel.color : spr_pixel.color;
+            }
+
+            draw_pixel(color, (256 * scanline) + ppu_cycle);
         }
 
         if (ppu_cycle >= 257 && ppu_cycle < 321)
@@ -682,7 +935,13 @@ void PPU::run_cycle()
     {
         if (ppu_cycle == 1)
         {
-            mmu->update_framebuffer(framebuffer.data());
+            mmu->update_framebuffer(frame_output ? framebuffer.data() : nullptr);
+
+            if (frame_period != 0)
+            {
+                frame_number = (frame_number + 1) % frame_period;
+                frame_output = frame_number >= skipped_frames;
+            }
 
             if (!suppress_vblank_flag)
             {
@@ -699,4 +958,81 @@ void PPU::run_cycle()
 
     nmi_evaluation();
     tick();
+}
+
+void PPU::skip_dots(const uint16_t count)
+{
+    const uint16_t first = ppu_cycle;
+    const uint16_t end = ppu_cycle + count;
+
+    if (scanline < 240 || scanline == 261)
+    {
+        // the shifters keep moving while rendering is off, they make up the first pixels once it's back on
+        const uint16_t shifts = std::max(0, std::min<int>(end, 257) - std::max<int>(first, 1)) +
+                                std::max(0, std::min<int>(end, 337) - std::max<int>(first, 321));
+
+        if (shifts != 0)
+        {
+            const uint8_t fill[2] = { (uint8_t)(bg.at_latch[0] ? 0xffu : 0), (uint8_t)(bg.at_latch[1] ? 0xffu : 0) };
+
+            for (uint8_t plane = 0; plane < 2; plane++)
+            {
+                bg.tile_shifter[plane] = (shifts < 16) ? (uint16_t)(bg.tile_shifter[plane] << shifts) : 0;
+                bg.at_shifter[plane] = (shifts < 8) ?
+                        (uint8_t)((bg.at_shifter[plane] << shifts) | (fill[plane] >> (8u - shifts))) : fill[plane];
+            }
+        }
+
+        if (frame_output && scanline != 261 && first < 256)
+        {
+            const uint32_t offset = (256 * scanline) + first;
+
+            draw_pixel(read_memory(0x3f00), offset);
+            std::fill(framebuffer.begin() + offset + 1, framebuffer.begin() + 256 * scanline + std::min<uint16_t>(end, 256),
+                      framebuffer[offset]);
+        }
+
+        if (first < 321 && end > 257)
+        {
+            regs.oamaddr = 0;
+        }
+    }
+
+    // nothing in between changes the NMI inputs, so evaluating once covers every dot
+    nmi_evaluation();
+
+    ppu_cycle = end - 1;
+    tick();
+}
+
+void PPU::run_cycles(uint64_t count)
+{
+    while (count != 0)
+    {
+        // with rendering off, and during vblank, dots other than the flag updates at dot 1 only draw the backdrop
+        // and shift the background, so the rest of the line can go in one step
+        if (!is_rendering() || (scanline >= 240 && scanline < 261))
+        {
+            const bool flag_line = scanline == 241 || scanline == 261;
+
+            if (!flag_line || ppu_cycle != 1)
+            {
+                const uint16_t line_end = (flag_line && ppu_cycle == 0) ? 1 : 341;
+                const uint16_t dots = (uint16_t)std::min<uint64_t>(count, line_end - ppu_cycle);
+
+                skip_dots(dots);
+                count -= dots;
+                continue;
+            }
+        }
+
+        // nothing touches the PPU until the batch ends, so a line's background can be drawn before its dots run
+        if (ppu_cycle <= 1 && scanline < 240 && !bg.line_ready && count >= 257u - ppu_cycle && is_rendering())
+        {
+            render_background_line();
+        }
+
+        run_cycle();
+        --count;
+    }
 }
\ No newline at end of file
@@ -3,9 +3,12 @@
 #define CIEL_PPU_H
 
 
+#include <array>
 #include <memory>
 #include <vector>
 
+#include "..//mmu/mappers/mapper_interface/mapper.h"
+
 struct PPU_Registers
 {
     uint8_t ppuctrl;
@@ -38,6 +41,10 @@ struct Background
     uint16_t nametable_address;
     uint16_t nametable_byte;
     uint16_t tile_address;
+
+    // palette RAM indices of a line drawn ahead of its dots, valid for dots 0 to 256 while line_ready is set
+    bool line_ready;
+    uint8_t line[257];
 };
 
 struct Sprite
@@ -52,6 +59,21 @@ struct Sprite
     uint8_t x_pos[8];
 
     bool sprite_zero_on_line;
+
+    // secondary OAM drawn out for every dot, palette RAM offset from 3F10h in bits 0-4, behind background in bit 5
+    // and slot 0 in bit 6, rebuilt on first use after anything it was drawn from has changed
+    bool line_ready;
+    uint8_t line[256];
+};
+
+// one 8-pixel row of a CHR tile, with its 2-bit pixels decoded one per byte, leftmost in the lowest byte
+struct CHR_Row
+{
+    bool valid;
+    uint8_t low;
+    uint8_t high;
+    uint64_t pixels;
+    uint64_t flipped_pixels;
 };
 
 struct Pixel
@@ -91,6 +113,16 @@ private:
     std::vector<uint8_t> oam_2;
     std::vector<uint8_t> vram;
 
+    // host pointers to the 1 KiB pages of the pattern tables and nametables, set by the mapper on bank or mirroring
+    // changes, CHR write pages are nullptr while CHR is ROM
+    std::array<const uint8_t *, 8> chr_pages;
+    std::array<uint8_t *, 8> chr_write_pages;
+    std::array<uint8_t *, 4> nt_pages;
+
+    // indexed by tile and row, filled on first use and dropped when CHR is written or banks may have switched
+    std::vector<CHR_Row> chr_rows;
+    CHR_Row uncached_row;
+
     uint8_t internal_bus;
     uint16_t ppu_cycle;
     uint16_t scanline;
@@ -99,6 +131,12 @@ private:
     bool suppress_vblank_flag;
     bool even_frame;
 
+    // skipped frames only run what the game can observe and hand no pixels over
+    bool frame_output;
+    uint8_t skipped_frames;
+    uint8_t frame_period;
+    uint8_t frame_number;
+
     inline void tick();
     inline void nmi_evaluation();
 
@@ -111,12 +149,18 @@ private:
     inline uint8_t read_memory(uint16_t address);
     inline void write_memory(uint8_t byte);
 
+    inline void decode_chr_row(CHR_Row &row, uint16_t address);
+    [[nodiscard]] inline const CHR_Row &read_chr_row(uint16_t address);
+
     void background_fetch();
     void sprite_fetch();
+    void render_background_line();
+    void render_sprite_line();
+    void skip_dots(uint16_t count);
     Pixel background_pixel();
     Pixel sprite_pixel(Pixel &bg_pixel);
 
-    inline void draw_pixel(uint8_t color, uint64_t offset);
+    inline void draw_pixel(uint8_t color, uint32_t offset);
 
     inline uint8_t read_ppustatus();
     inline uint8_t read_ppudata();
@@ -128,12 +172,24 @@ public:
     explicit PPU(const std::shared_ptr<MMU> &mmu);
     ~PPU();
 
-    std::vector<uint8_t> framebuffer;
+    // palette indices with emphasis, see Palette
+    std::vector<uint16_t> framebuffer;
 
     uint8_t read_register(uint16_t address);
     void write_register(uint8_t byte, uint16_t address);
 
+    // skips drawing the first skipped of every period frames
+    void set_frame_skip(uint8_t skipped, uint8_t period);
+
+    void map_chr(uint8_t page, const uint8_t *read_page, uint8_t *write_page);
+    void map_nametables(Mirroring mirroring);
+    void invalidate_chr_rows();
+
+    [[nodiscard]] uint32_t dots_until_vblank() const;
+    [[nodiscard]] uint32_t dots_until_nmi() const;
+
     void run_cycle();
+    void run_cycles(uint64_t count);
 };
 
 
@@ -0,0 +1,65 @@
+#include "scheduler.h"
+
+#include <limits>
+
+constexpr uint64_t no_deadline = std::numeric_limits<uint64_t>::max();
+
+Scheduler::Scheduler() :
+deadlines(), master_clock(0), next_deadline(no_deadline)
+{
+    for (uint64_t &deadline : deadlines)
+    {
+        deadline = no_deadline;
+    }
+}
+
+Scheduler::~Scheduler()
+= default;
+
+void Scheduler::update_next_deadline()
+{
+    next_deadline = no_deadline;
+
+    for (const uint64_t deadline : deadlines)
+    {
+        if (deadline < next_deadline)
+        {
+            next_deadline = deadline;
+        }
+    }
+}
+
+void Scheduler::schedule(const Event_Type type, const uint64_t delay)
+{
+    deadlines[type] = master_clock + delay;
+
+    update_next_deadline();
+}
+
+void Scheduler::cancel(const Event_Type type)
+{
+    deadlines[type] = no_deadline;
+
+    update_next_deadline();
+}
+
+bool Scheduler::pop_due_event(Event_Type &type)
+{
+    if (next_deadline > master_clock)
+    {
+        return false;
+    }
+
+    for (uint8_t event = 0; event < EventCount; event++)
+    {
+        if (deadlines[event] == next_deadline)
+        {
+            type = (Event_Type)event;
+
+            cancel(type);
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef CIEL_SCHEDULER_H
+#define CIEL_SCHEDULER_H
+
+
+#include <cstdint>
+
+// NTSC master clock ticks per CPU cycle and per PPU dot
+constexpr uint64_t cpu_clock_divider = 12;
+constexpr uint64_t ppu_clock_divider = 4;
+
+enum Event_Type
+{
+    JoypadEvent,
+    PPUSyncEvent,
+    HaltEvent,
+    EventCount
+};
+
+// one pending deadline per event type on the master clock, so there is no queue to keep sorted
+class Scheduler
+{
+private:
+    uint64_t deadlines[EventCount];
+
+    void update_next_deadline();
+public:
+    Scheduler();
+    ~Scheduler();
+
+    uint64_t master_clock;
+
+    // the earliest pending deadline, events scheduled mid-step end the current run of steps through it
+    uint64_t next_deadline;
+
+    void schedule(Event_Type type, uint64_t delay = 0);
+    void cancel(Event_Type type);
+    bool pop_due_event(Event_Type &type);
+};
+
+
+#endif //CIEL_SCHEDULER_H
@@ -0,0 +1,126 @@
+#include "nes.h"
+#include "mmu/mmu.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct Benchmark_Config
+{
+    const char *name;
+    Stepping_Mode stepping_mode;
+    bool block_translation;
+    // only built for the default ROM
+    bool recompiled;
+};
+
+static const Benchmark_Config configs[] = {
+        { "cycle-stepped", CycleStepped, false, false },
+        { "instruction-stepped", InstructionStepped, false, false },
+        { "block-translated", InstructionStepped, true, false },
+        { "recompiled", InstructionStepped, true, true }
+};
+
+static void run_benchmark(const Benchmark_Config &config, const char *cartridge_path, const uint64_t frames)
+{
+    NES nes(cartridge_path, config.stepping_mode);
+
+    if (config.block_translation)
+    {
+        nes.enable_block_translation(true);
+    }
+
+    if (config.recompiled)
+    {
+        nes.load_recompiled(CIEL_RECOMPILED_NROM);
+    }
+
+    const uint64_t start_cycles = nes.get_cycles();
+    const auto start = std::chrono::steady_clock::now();
+
+    nes.run(frames);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t cycles = nes.get_cycles() - start_cycles;
+
+    printf("[Bench] %-20s %" PRIu64 " frames, %" PRIu64 " cycles in %.3f s, %.2f M cycles/s\n", config.name, frames,
+           cycles, seconds, cycles / seconds / 1e6);
+}
+
+constexpr uint32_t read_passes = 2000;
+
+// the call CPU::read_memory made before MMU::read_byte was defined in the header
+[[gnu::noinline]] static uint8_t read_byte_out_of_line(MMU &mmu, const uint16_t address)
+{
+    return mmu.read_byte(address);
+}
+
+template <bool inline_read>
+static void run_read_benchmark(MMU &mmu, const std::vector<uint16_t> &addresses)
+{
+    uint32_t sum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t pass = 0; pass < read_passes; pass++)
+    {
+        for (const uint16_t address : addresses)
+        {
+            sum += inline_read ? mmu.read_byte(address) : read_byte_out_of_line(mmu, address);
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double reads = (double)read_passes * addresses.size();
+
+    printf("[Bench] %-20s %.0f reads in %.3f s, %.2f M reads/s, checksum %08X\n",
+           inline_read ? "inline reads" : "out-of-line reads", reads, seconds, reads / seconds / 1e6, sum);
+}
+
+// times the CPU's read path alone on an MMU with no PPU, over RAM and PRG addresses in the mix code fetches them
+static void run_read_benchmarks(const char *cartridge_path)
+{
+    MMU mmu(nullptr, nullptr, cartridge_path);
+    std::vector<uint16_t> addresses(0x10000);
+    uint32_t state = 1;
+
+    for (uint16_t &address : addresses)
+    {
+        state = state * 1103515245u + 12345u;
+
+        // three of every four reads are from PRG-ROM
+        address = ((state >> 16u) & 3u) ? 0x8000u | (state >> 1u & 0x7fffu) : (state >> 1u & 0x7ffu);
+    }
+
+    run_read_benchmark<false>(mmu, addresses);
+    run_read_benchmark<true>(mmu, addresses);
+}
+
+// runs a number of frames of a ROM headless in every stepping mode and prints the emulated CPU cycles per second
+int main(int argc, char **argv)
+{
+    const char *cartridge_path = (argc > 1) ? argv[1] : CIEL_TEST_ROM_DIR "/nrom.nes";
+    const uint64_t frames = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 600;
+
+    if (frames == 0)
+    {
+        printf("[Bench] Usage: %s [ROM path] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    for (const Benchmark_Config &config : configs)
+    {
+        if (config.recompiled && argc > 1)
+        {
+            continue;
+        }
+
+        run_benchmark(config, cartridge_path, frames);
+    }
+
+    run_read_benchmarks(cartridge_path);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "cpu/code_tracer.h"
+
+#include <cstdio>
+
+// writes the C++ source of a recompiled module for a ROM, the way --recompile does, for builds without SDL2
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        printf("[Recompile] Usage: %s <ROM path> <source path>\n", argv[0]);
+        return 1;
+    }
+
+    Code_Tracer(argv[1]).write_module(argv[2]);
+
+    return 0;
+}
\ No newline at end of file
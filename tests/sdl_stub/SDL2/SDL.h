@@ -0,0 +1,93 @@
+#pragma once
+#ifndef CIEL_SDL_STUB_H
+#define CIEL_SDL_STUB_H
+
+
+#include <cstdint>
+
+// the part of SDL2 the emulator uses, with no window, no renderer and no input behind it, so that the core can be
+// benchmarked and tested headless
+
+typedef struct SDL_Window SDL_Window;
+typedef struct SDL_Renderer SDL_Renderer;
+typedef struct SDL_Texture SDL_Texture;
+typedef struct SDL_Rect SDL_Rect;
+
+typedef int32_t SDL_Keycode;
+typedef int32_t SDL_Scancode;
+
+enum SDL_bool
+{
+    SDL_FALSE,
+    SDL_TRUE
+};
+
+enum
+{
+    SDL_QUIT = 0x100,
+    SDL_KEYDOWN = 0x300,
+    SDL_KEYUP
+};
+
+union SDL_Event
+{
+    uint32_t type;
+    uint8_t padding[56];
+};
+
+enum
+{
+    SDLK_BACKSPACE = 8,
+    SDLK_x = 'x',
+    SDLK_y = 'y',
+    SDLK_KP_ENTER = 88,
+    SDLK_RIGHT = 79,
+    SDLK_LEFT,
+    SDLK_DOWN,
+    SDLK_UP
+};
+
+enum
+{
+    SDL_PIXELFORMAT_RGB24 = 1,
+    SDL_PIXELFORMAT_RGB565,
+    SDL_PIXELFORMAT_RGB888
+};
+
+enum
+{
+    SDL_TEXTUREACCESS_STREAMING = 1
+};
+
+#define SDL_INIT_VIDEO 0x20u
+#define SDL_HINT_RENDER_VSYNC "SDL_RENDER_VSYNC"
+
+int SDL_Init(uint32_t flags);
+SDL_bool SDL_SetHint(const char *name, const char *value);
+
+int SDL_CreateWindowAndRenderer(int width, int height, uint32_t window_flags, SDL_Window **window,
+                                SDL_Renderer **renderer);
+void SDL_SetWindowSize(SDL_Window *window, int width, int height);
+void SDL_SetWindowResizable(SDL_Window *window, SDL_bool resizable);
+void SDL_SetWindowTitle(SDL_Window *window, const char *title);
+
+int SDL_RenderSetLogicalSize(SDL_Renderer *renderer, int width, int height);
+SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer, uint32_t format, int access, int width, int height);
+void SDL_DestroyTexture(SDL_Texture *texture);
+int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch);
+int SDL_RenderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect *source, const SDL_Rect *target);
+void SDL_RenderPresent(SDL_Renderer *renderer);
+
+void SDL_PumpEvents();
+SDL_bool SDL_HasEvent(uint32_t type);
+int SDL_PollEvent(SDL_Event *event);
+const uint8_t *SDL_GetKeyboardState(int *key_count);
+SDL_Scancode SDL_GetScancodeFromKey(SDL_Keycode key);
+
+// shared objects are loaded for real, so recompiled modules can be tested headless
+void *SDL_LoadObject(const char *file);
+void *SDL_LoadFunction(void *handle, const char *name);
+void SDL_UnloadObject(void *handle);
+
+
+#endif //CIEL_SDL_STUB_H
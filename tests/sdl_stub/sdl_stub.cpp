@@ -0,0 +1,152 @@
+#include "SDL2/SDL.h"
+
+#include <dlfcn.h>
+
+// nothing is ever pressed
+static const uint8_t keyboard_state[512] = {};
+
+int SDL_Init(const uint32_t flags)
+{
+    (void)flags;
+
+    return 0;
+}
+
+SDL_bool SDL_SetHint(const char *name, const char *value)
+{
+    (void)name;
+    (void)value;
+
+    return SDL_TRUE;
+}
+
+int SDL_CreateWindowAndRenderer(const int width, const int height, const uint32_t window_flags, SDL_Window **window,
+                                SDL_Renderer **renderer)
+{
+    (void)width;
+    (void)height;
+    (void)window_flags;
+
+    *window = nullptr;
+    *renderer = nullptr;
+
+    return 0;
+}
+
+void SDL_SetWindowSize(SDL_Window *window, const int width, const int height)
+{
+    (void)window;
+    (void)width;
+    (void)height;
+}
+
+void SDL_SetWindowResizable(SDL_Window *window, const SDL_bool resizable)
+{
+    (void)window;
+    (void)resizable;
+}
+
+void SDL_SetWindowTitle(SDL_Window *window, const char *title)
+{
+    (void)window;
+    (void)title;
+}
+
+int SDL_RenderSetLogicalSize(SDL_Renderer *renderer, const int width, const int height)
+{
+    (void)renderer;
+    (void)width;
+    (void)height;
+
+    return 0;
+}
+
+SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer, const uint32_t format, const int access, const int width,
+                               const int height)
+{
+    (void)renderer;
+    (void)format;
+    (void)access;
+    (void)width;
+    (void)height;
+
+    return nullptr;
+}
+
+void SDL_DestroyTexture(SDL_Texture *texture)
+{
+    (void)texture;
+}
+
+int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, const int pitch)
+{
+    (void)texture;
+    (void)rect;
+    (void)pixels;
+    (void)pitch;
+
+    return 0;
+}
+
+int SDL_RenderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect *source, const SDL_Rect *target)
+{
+    (void)renderer;
+    (void)texture;
+    (void)source;
+    (void)target;
+
+    return 0;
+}
+
+void SDL_RenderPresent(SDL_Renderer *renderer)
+{
+    (void)renderer;
+}
+
+void SDL_PumpEvents()
+{
+}
+
+SDL_bool SDL_HasEvent(const uint32_t type)
+{
+    (void)type;
+
+    return SDL_FALSE;
+}
+
+int SDL_PollEvent(SDL_Event *event)
+{
+    (void)event;
+
+    return 0;
+}
+
+const uint8_t *SDL_GetKeyboardState(int *key_count)
+{
+    if (key_count != nullptr)
+    {
+        *key_count = sizeof(keyboard_state);
+    }
+
+    return keyboard_state;
+}
+
+SDL_Scancode SDL_GetScancodeFromKey(const SDL_Keycode key)
+{
+    return key & 0x1ff;
+}
+
+void *SDL_LoadObject(const char *file)
+{
+    return dlopen(file, RTLD_NOW | RTLD_LOCAL);
+}
+
+void *SDL_LoadFunction(void *handle, const char *name)
+{
+    return dlsym(handle, name);
+}
+
+void SDL_UnloadObject(void *handle)
+{
+    dlclose(handle);
+}
\ No newline at end of file
@@ -0,0 +1,365 @@
+#include "nes.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+struct Test_Case
+{
+    const char *name;
+    bool (*run)();
+};
+
+struct Machine_Hashes
+{
+    uint64_t ram;
+    uint64_t framebuffer;
+};
+
+// FNV-1a
+static uint64_t hash_bytes(const void *data, const size_t size)
+{
+    const auto *bytes = (const uint8_t *)data;
+    uint64_t hash = 0xcbf29ce484222325u;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3u;
+    }
+
+    return hash;
+}
+
+static Machine_Hashes hash_machine(const NES &nes)
+{
+    return { hash_bytes(nes.get_ram(), 0x800), hash_bytes(nes.get_framebuffer(), 256 * 240 * sizeof(uint16_t)) };
+}
+
+static bool check_hashes(const char *what, const Machine_Hashes &expected, const Machine_Hashes &actual)
+{
+    if (expected.ram == actual.ram && expected.framebuffer == actual.framebuffer)
+    {
+        return true;
+    }
+
+    printf("[Test] %s: RAM %016" PRIx64 " != %016" PRIx64 " or framebuffer %016" PRIx64 " != %016" PRIx64 "\n", what,
+           actual.ram, expected.ram, actual.framebuffer, expected.framebuffer);
+
+    return false;
+}
+
+constexpr uint64_t interleave_slice = 997;
+constexpr uint64_t interleave_cycles = 2000000;
+
+// runs in slices of interleave_slice CPU cycles, so that solo and interleaved runs halt at the same points
+static void run_slice(NES &nes)
+{
+    nes.run_cycles(interleave_slice);
+}
+
+static Machine_Hashes run_solo(const char *cartridge_path, const Stepping_Mode stepping_mode)
+{
+    NES nes(cartridge_path, stepping_mode);
+
+    for (uint64_t cycles = 0; cycles < interleave_cycles; cycles += interleave_slice)
+    {
+        run_slice(nes);
+    }
+
+    return hash_machine(nes);
+}
+
+// two instances stepped alternately have to end up exactly where each of them ends up alone
+static bool test_interleaved(const Stepping_Mode stepping_mode)
+{
+    const char *nrom_path = CIEL_TEST_ROM_DIR "/nrom.nes";
+    const char *axrom_path = CIEL_TEST_ROM_DIR "/axrom.nes";
+
+    const Machine_Hashes nrom_solo = run_solo(nrom_path, stepping_mode);
+    const Machine_Hashes axrom_solo = run_solo(axrom_path, stepping_mode);
+
+    auto nrom = std::make_unique<NES>(nrom_path, stepping_mode);
+    auto axrom = std::make_unique<NES>(axrom_path, stepping_mode);
+
+    for (uint64_t cycles = 0; cycles < interleave_cycles; cycles += interleave_slice)
+    {
+        run_slice(*nrom);
+        run_slice(*axrom);
+    }
+
+    const bool nrom_ok = check_hashes("interleaved NROM", nrom_solo, hash_machine(*nrom));
+    const bool axrom_ok = check_hashes("interleaved AxROM", axrom_solo, hash_machine(*axrom));
+
+    return nrom_ok && axrom_ok;
+}
+
+static bool test_interleaved_cycle_stepped()
+{
+    return test_interleaved(CycleStepped);
+}
+
+static bool test_interleaved_instruction_stepped()
+{
+    return test_interleaved(InstructionStepped);
+}
+
+constexpr uint64_t frame_skip_frames = 300;
+
+// skipped frames hand no pixels over, but whatever the game can observe has to stay the same
+static bool test_frame_skip(const Stepping_Mode stepping_mode)
+{
+    bool passed = true;
+
+    for (const char *cartridge_path : { CIEL_TEST_ROM_DIR "/nrom.nes", CIEL_TEST_ROM_DIR "/axrom.nes" })
+    {
+        NES full(cartridge_path, stepping_mode);
+        NES skipping(cartridge_path, stepping_mode);
+
+        skipping.enable_frame_skip(3, 4);
+
+        full.run(frame_skip_frames);
+        skipping.run(frame_skip_frames);
+
+        const uint64_t full_hash = hash_bytes(full.get_ram(), 0x800);
+        const uint64_t skipping_hash = hash_bytes(skipping.get_ram(), 0x800);
+
+        if (full_hash != skipping_hash || full.get_cycles() != skipping.get_cycles())
+        {
+            printf("[Test] %s with 3/4 frames skipped: RAM %016" PRIx64 " != %016" PRIx64 " or cycles %" PRIu64
+                   " != %" PRIu64 "\n", cartridge_path, skipping_hash, full_hash, skipping.get_cycles(),
+                   full.get_cycles());
+
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+static bool test_frame_skip_cycle_stepped()
+{
+    return test_frame_skip(CycleStepped);
+}
+
+static bool test_frame_skip_instruction_stepped()
+{
+    return test_frame_skip(InstructionStepped);
+}
+
+constexpr uint64_t block_translation_frames = 300;
+
+// blocks run the same handlers as instruction stepping, just without decoding in between
+static bool test_block_translation()
+{
+    bool passed = true;
+
+    for (const char *cartridge_path : { CIEL_TEST_ROM_DIR "/nrom.nes", CIEL_TEST_ROM_DIR "/axrom.nes" })
+    {
+        NES stepped(cartridge_path, InstructionStepped);
+        NES translated(cartridge_path, InstructionStepped);
+
+        translated.enable_block_translation(true);
+
+        stepped.run(block_translation_frames);
+        translated.run(block_translation_frames);
+
+        passed = check_hashes(cartridge_path, hash_machine(stepped), hash_machine(translated)) && passed;
+
+        if (stepped.get_cycles() != translated.get_cycles())
+        {
+            printf("[Test] %s: cycles %" PRIu64 " != %" PRIu64 "\n", cartridge_path, translated.get_cycles(),
+                   stepped.get_cycles());
+
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+// the module runs the NROM test ROMs' code with the same bus accesses at the same cycles as the handlers it replaces,
+// and stays in use after writes to PRG-ROM, which switch no banks on NROM
+static bool test_recompiled()
+{
+    struct Recompiled_Case
+    {
+        const char *cartridge_path;
+        const char *module_path;
+    };
+
+    static const Recompiled_Case cases[] = {
+            { CIEL_TEST_ROM_DIR "/nrom.nes", CIEL_RECOMPILED_NROM },
+            // nrom.nes with STA $8000 in its reset code
+            { CIEL_TEST_ROM_DIR "/nrom_rom_write.nes", CIEL_RECOMPILED_NROM_ROM_WRITE }
+    };
+
+    bool passed = true;
+
+    for (const Recompiled_Case &test_case : cases)
+    {
+        NES translated(test_case.cartridge_path, InstructionStepped);
+        NES recompiled(test_case.cartridge_path, InstructionStepped);
+
+        translated.enable_block_translation(true);
+        recompiled.load_recompiled(test_case.module_path);
+
+        translated.run(block_translation_frames);
+        recompiled.run(block_translation_frames / 2);
+
+        const uint64_t halfway_cycles = recompiled.get_recompiled_cycles();
+
+        recompiled.run(block_translation_frames / 2);
+
+        passed = check_hashes(test_case.cartridge_path, hash_machine(translated), hash_machine(recompiled)) && passed;
+
+        if (translated.get_cycles() != recompiled.get_cycles())
+        {
+            printf("[Test] %s: cycles %" PRIu64 " != %" PRIu64 "\n", test_case.cartridge_path,
+                   recompiled.get_cycles(), translated.get_cycles());
+
+            passed = false;
+        }
+
+        if (recompiled.get_recompiled_cycles() == halfway_cycles)
+        {
+            printf("[Test] %s: module out of use after %" PRIu64 " recompiled cycles\n", test_case.cartridge_path,
+                   halfway_cycles);
+
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+// the counters are read between frames, so they have to hold the finished frame's numbers rather than be reset
+static bool test_idle_counters()
+{
+    NES nes(CIEL_TEST_ROM_DIR "/nrom.nes", CycleStepped);
+    uint64_t idle_cycles = 0;
+
+    nes.enable_idle_skipping();
+
+    // the test ROM waits for the PPU to warm up in an idle loop
+    for (uint8_t frame = 0; frame < 10; frame++)
+    {
+        nes.run(1);
+
+        idle_cycles += nes.idle_cycles_skipped;
+    }
+
+    if (idle_cycles == 0)
+    {
+        printf("[Test] No idle cycles counted in 10 frames\n");
+        return false;
+    }
+
+    return true;
+}
+
+// every format has to hold the same colors, in exactly the number of bytes the buffers are sized for
+static bool test_pixel_formats()
+{
+    constexpr uint32_t frame_pixels = 256 * 240;
+    constexpr uint8_t guard = 0xaa;
+
+    const Palette palette;
+    std::vector<uint16_t> frame(frame_pixels);
+
+    for (uint32_t pixel = 0; pixel < frame_pixels; pixel++)
+    {
+        frame[pixel] = pixel & 0x1ffu;
+    }
+
+    std::vector<uint8_t> converted[3];
+
+    for (const Pixel_Format format : { RGB24, XRGB8888, RGB565 })
+    {
+        const uint32_t size = frame_pixels * Palette::bytes_per_pixel(format);
+
+        converted[format].assign(size + 16, guard);
+
+        palette.convert(frame.data(), format, converted[format].data());
+
+        for (uint32_t i = size; i < size + 16; i++)
+        {
+            if (converted[format][i] != guard)
+            {
+                printf("[Test] Format %u wrote past %u bytes\n", format, size);
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t pixel = 0; pixel < frame_pixels; pixel++)
+    {
+        const uint8_t *rgb = &converted[RGB24][3 * pixel];
+        uint32_t xrgb;
+        uint16_t rgb565;
+
+        std::memcpy(&xrgb, &converted[XRGB8888][4 * pixel], sizeof(xrgb));
+        std::memcpy(&rgb565, &converted[RGB565][2 * pixel], sizeof(rgb565));
+
+        if (xrgb != (uint32_t)((rgb[0] << 16u) | (rgb[1] << 8u) | rgb[2]) ||
+            rgb565 != (uint16_t)(((rgb[0] >> 3u) << 11u) | ((rgb[1] >> 2u) << 5u) | (rgb[2] >> 3u)))
+        {
+            printf("[Test] Formats disagree on color %03Xh\n", frame[pixel]);
+            return false;
+        }
+    }
+
+    // and the emulator has to draw into each of them
+    for (const Pixel_Format format : { RGB24, XRGB8888, RGB565 })
+    {
+        NES nes(CIEL_TEST_ROM_DIR "/nrom.nes");
+
+        nes.set_pixel_format(format);
+        nes.run(2);
+    }
+
+    return true;
+}
+
+static const Test_Case tests[] = {
+        { "interleaved_cycle_stepped", test_interleaved_cycle_stepped },
+        { "interleaved_instruction_stepped", test_interleaved_instruction_stepped },
+        { "frame_skip_cycle_stepped", test_frame_skip_cycle_stepped },
+        { "frame_skip_instruction_stepped", test_frame_skip_instruction_stepped },
+        { "block_translation", test_block_translation },
+        { "idle_counters", test_idle_counters },
+        { "pixel_formats", test_pixel_formats },
+        { "recompiled", test_recompiled }
+};
+
+// runs the named test, or every test without a name, and fails if any of them does
+int main(int argc, char **argv)
+{
+    bool found = false;
+    bool passed = true;
+
+    for (const Test_Case &test : tests)
+    {
+        if (argc > 1 && std::strcmp(argv[1], test.name) != 0)
+        {
+            continue;
+        }
+
+        found = true;
+
+        const bool ok = test.run();
+
+        printf("[Test] %s: %s\n", test.name, ok ? "passed" : "FAILED");
+
+        passed = passed && ok;
+    }
+
+    if (!found)
+    {
+        printf("[Test] Unknown test %s!\n", argv[1]);
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file